@@ -82,6 +82,10 @@ if (CONFIG_AT_BASE_ON_UART)
     target_link_libraries(${COMPONENT_LIB} INTERFACE "-u esp_at_uart_cmd_regist")
 endif()
 
+if (CONFIG_AT_BASE_ON_SPI)
+    target_link_libraries(${COMPONENT_LIB} INTERFACE "-u esp_at_spi_cmd_regist")
+endif()
+
 if (CONFIG_AT_SIGNALING_COMMAND_SUPPORT)
     target_link_libraries(${COMPONENT_LIB} INTERFACE "-u esp_at_fact_cmd_regist")
 endif()
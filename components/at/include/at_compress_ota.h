@@ -11,6 +11,8 @@
 #include "esp_err.h"
 #include "esp_http_client.h"
 #include "esp_partition.h"
+#include "esp_rom_md5.h"
+#include "bootloader_custom_ota.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,11 +34,17 @@ typedef struct {
     uint32_t compressed_img_size;           /*!< The compressed image size to be written */
     bool image_header_checked;              /*!< The compressed image header checked done */
     const esp_partition_t *partition;       /*!< The partition to hold on compressed image */
+    md5_context_t md5_context;              /*!< The MD5 context of the compressed image body that has been written */
+    uint32_t erased_size;                   /*!< The size of the partition that has been erased ahead of the writes */
+    bootloader_custom_ota_header_t header;  /*!< The compressed image header staged until it is complete */
+    uint32_t header_len;                    /*!< The length of the staged header */
 } at_compress_ota_handle_t;
 
 /**
  * @brief  Commence an Compress OTA upgrade writing to the specified partition.
  *
+ * @note   The partition is not erased here, the sectors are erased just ahead of at_compress_ota_write().
+ *
  * @param[out]   handle On success, returns a handle which should be used for subsequent at_compress_ota_write() and at_compress_ota_end() calls.
  *
  * @return
@@ -45,9 +53,34 @@ typedef struct {
  */
 esp_err_t at_compress_ota_begin(at_compress_ota_handle_t *handle);
 
+/**
+ * @brief  Commence an Compress OTA upgrade which continues an interrupted download from the specified offset.
+ *
+ * @note   The compressed image header which has been written to the partition is checked again,
+ *         and the partition is written from the offset.
+ *
+ * @param[out]   handle On success, returns a handle which should be used for subsequent at_compress_ota_write() and at_compress_ota_end() calls.
+ * @param[in]    offset The offset to continue writing from, it must be aligned to the flash sector size. 0: start from the beginning.
+ *
+ * @return
+ *    - ESP_OK: Compress OTA operation commenced successfully.
+ *    - others: Compress OTA operation commenced failed.
+ */
+esp_err_t at_compress_ota_begin_with_offset(at_compress_ota_handle_t *handle, uint32_t offset);
+
+/**
+ * @brief  Get the partition which holds on the compressed image.
+ *
+ * @return
+ *    - the pointer of the partition, NULL if the partition is not found.
+ */
+const esp_partition_t *at_compress_ota_partition_get(void);
+
 /**
  * @brief  Write Compress OTA upgrade data to partition.
  *
+ * @note   The data can be fed in chunks of any size, the compressed image header is staged in the handle until it is complete.
+ *
  * @param[in] handle    Handle obtained from at_compress_ota_begin()
  * @param[in] data      Data buffer to write
  * @param[in] size      Size of data buffer in bytes
@@ -0,0 +1,134 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_http_client.h"
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_rom_md5.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Delta OTA
+ *
+ *  An OTA method for saving the download size. Typical workflow:
+ *  Generate a delta image from the running firmware and the new firmware by tools/at_delta_gen.py,
+ *  Delta OTA downloads the delta image, rebuilds the new firmware from the running partition while streaming,
+ *  and writes it into the next update partition.
+ *
+ *  Delta image layout (little endian):
+ *      at_delta_ota_header_t | op | op | ... | op
+ *  Each op starts with at_delta_ota_op_t:
+ *      - AT_DELTA_OTA_OP_COPY:   copy <len> bytes of the running firmware from <src_offset>
+ *      - AT_DELTA_OTA_OP_INSERT: followed by <len> bytes of new data
+ *      - AT_DELTA_OTA_OP_DIFF:   rebuild <len> bytes from <src_offset> of the running firmware, followed by records of
+ *                                {uint16_t same_len, uint16_t diff_len, uint8_t data[diff_len]}: copy same_len bytes
+ *                                of the running firmware, then replace the next diff_len bytes with data
+ */
+
+#define AT_DELTA_OTA_MAGIC                  "ATDP"
+#define AT_DELTA_OTA_VERSION                1
+
+typedef enum {
+    AT_DELTA_OTA_OP_COPY = 1,
+    AT_DELTA_OTA_OP_INSERT,
+    AT_DELTA_OTA_OP_DIFF,
+} at_delta_ota_op_type_t;
+
+typedef struct {
+    char magic[4];                          /*!< AT_DELTA_OTA_MAGIC */
+    uint16_t version;                       /*!< AT_DELTA_OTA_VERSION */
+    uint16_t header_len;                    /*!< sizeof(at_delta_ota_header_t) */
+    uint32_t src_size;                      /*!< The size of the running firmware that the delta is generated from */
+    uint32_t dst_size;                      /*!< The size of the new firmware */
+    uint8_t src_md5[16];                    /*!< The MD5 of the running firmware */
+    uint8_t dst_md5[16];                    /*!< The MD5 of the new firmware */
+} __attribute__((packed)) at_delta_ota_header_t;
+
+typedef struct {
+    uint8_t type;                           /*!< at_delta_ota_op_type_t */
+    uint32_t len;                           /*!< The length of the new firmware rebuilt by the op */
+    uint32_t src_offset;                    /*!< The offset of the running firmware, unused by AT_DELTA_OTA_OP_INSERT */
+} __attribute__((packed)) at_delta_ota_op_t;
+
+typedef struct {
+    const esp_partition_t *src_partition;   /*!< The running partition */
+    const esp_partition_t *dst_partition;   /*!< The partition to write the new firmware */
+    esp_ota_handle_t ota_handle;            /*!< The handle of esp_ota_begin(), 0: not begun */
+    at_delta_ota_header_t header;           /*!< The delta image header */
+    at_delta_ota_op_t op;                   /*!< The current op */
+    uint8_t stage[sizeof(at_delta_ota_op_t)];   /*!< The staged op header or diff record header */
+    uint32_t stage_len;                     /*!< The length of staged data */
+    uint32_t state;                         /*!< The state of the delta image parser */
+    uint32_t src_offset;                    /*!< The offset of the running firmware to read for the current op */
+    uint32_t op_remain;                     /*!< The length of the new firmware to rebuild by the current op */
+    uint32_t diff_remain;                   /*!< The length of new data to receive for the current diff record */
+    uint32_t wrote_size;                    /*!< The size of the new firmware that has been rebuilt */
+    md5_context_t md5_context;              /*!< The MD5 context of the new firmware */
+    uint8_t *buffer;                        /*!< The buffer of the new firmware to write */
+    uint32_t buffer_len;                    /*!< The length of data in the buffer */
+} at_delta_ota_handle_t;
+
+/**
+ * @brief  Commence a Delta OTA upgrade from the running partition to the next update partition.
+ *
+ * @param[out]   handle On success, the handle should be used for subsequent at_delta_ota_write() and at_delta_ota_end() calls.
+ *
+ * @return
+ *    - ESP_OK: Delta OTA operation commenced successfully.
+ *    - others: Delta OTA operation commenced failed.
+ */
+esp_err_t at_delta_ota_begin(at_delta_ota_handle_t *handle);
+
+/**
+ * @brief  Write the delta image data, the new firmware is rebuilt and written while streaming.
+ *
+ * @note   The data can be fed in chunks of any size.
+ *
+ * @param[in] handle    Handle obtained from at_delta_ota_begin()
+ * @param[in] data      Data buffer to write
+ * @param[in] size      Size of data buffer in bytes
+ *
+ * @return
+ *    - ESP_OK: Data was applied successfully.
+ *    - others: Data was applied failed, call at_delta_ota_end() to release the handle.
+ */
+esp_err_t at_delta_ota_write(at_delta_ota_handle_t *handle, const void *data, int size);
+
+/**
+ * @brief  Finish Delta OTA upgrade, validate the new firmware and set it as the boot partition.
+ *
+ * @note   The handle is released whether it succeeds or not.
+ *
+ * @param[in] handle    Handle obtained from at_delta_ota_begin()
+ *
+ * @return
+ *    - ESP_OK: The new firmware is valid, next reboot will use it.
+ *    - others: The new firmware is invalid.
+ */
+esp_err_t at_delta_ota_end(at_delta_ota_handle_t *handle);
+
+/**
+ * @brief  HTTP/HTTPS Delta OTA upgrade.
+ *
+ * @param[in] config    Pointer to esp_http_client_config_t structure
+ *
+ * @return
+ *    - ESP_OK: Delta OTA upgrade done, next reboot will use the new firmware.
+ *    - others: Delta OTA upgrade failed.
+ */
+esp_err_t at_delta_https_ota(const esp_http_client_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
@@ -168,3 +168,17 @@ esp_err_t esp_at_nvs_set_str(nvs_handle_t handle, const char *key, const char *v
 esp_err_t esp_at_nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length);
 esp_err_t esp_at_nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length);
 esp_err_t esp_at_nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length);
+
+#ifdef CONFIG_AT_NVS_WRITE_BACK_CACHE
+/**
+ * @brief Write back the values cached by esp_at_nvs_set_str() and esp_at_nvs_set_blob() to NVS, and commit them.
+ *
+ * @note The cached values are written back automatically once the writes are idle and before restart,
+ *       call it before the power is cut off, e.g., before deep sleep.
+ *
+ * @return
+ *  - ESP_OK: all the cached values are written back
+ *  - others: the error of the failed nvs operation, the value failed to write back is dropped
+ */
+esp_err_t esp_at_nvs_flush(void);
+#endif
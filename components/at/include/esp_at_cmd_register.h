@@ -52,6 +52,9 @@ typedef struct {
  *
  * @note The AT command set from outside the esp-at project register functions are recommended to be initialized by this macro.
  *
+ * @note The register functions run at every boot before AT is ready, so they are recommended to only register the command array,
+ *       and to allocate the resources of the command set (tasks, event groups, event handlers, etc) the first time its commands execute.
+ *
  * @param f: The function name to be register (identifier)
  * @param p: The priority of the initialization function. Higher values mean that the function will be executed later in the process.
  *
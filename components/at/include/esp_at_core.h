@@ -26,6 +26,16 @@ typedef struct {
     uint8_t (*at_exeCmd)(uint8_t *cmd_name);        /*!< Execute Command function pointer */
 } esp_at_cmd_struct;
 
+/**
+ * @brief esp_at_iovec_t
+ *  one data segment of a vectored write
+ *
+ */
+typedef struct {
+    const uint8_t *data;                            /*!< segment buffer */
+    int32_t len;                                    /*!< segment length */
+} esp_at_iovec_t;
+
 /**
  * @brief esp_at_device_ops_struct
  *  device operate functions struct for AT
@@ -37,10 +47,12 @@ typedef struct {
 
     int32_t (*get_data_length)(void);                               /*!< get the length of data received */
     bool (*wait_write_complete)(int32_t timeout_msec);              /*!< wait write finish */
+    int32_t (*writev_data)(const esp_at_iovec_t *iov, int32_t iovcnt);  /*!< write data segments into device as one transaction, optional (keep it the last member) */
 } esp_at_device_ops_struct;
 
 typedef int32_t (*at_read_data_fn_t)(uint8_t *data, int32_t len);
 typedef int32_t (*at_write_data_fn_t)(uint8_t *data, int32_t len);
+typedef int32_t (*at_writev_data_fn_t)(const esp_at_iovec_t *iov, int32_t iovcnt);
 typedef int32_t (*at_get_data_len_fn_t)(void);
 
 /**
@@ -0,0 +1,46 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * AT boot profiler
+ *
+ *  The phases of esp_at_init() are marked one after another, each mark records the time spent since the previous mark.
+ *  The first mark records the time spent before esp_at_init(), e.g., the bootloader, nvs_flash_init() and the event loop.
+ *  The report is printed once AT is ready: the phases sorted by their cost, followed by one line per phase in the format
+ *      AT_BOOT_PROF,<phase>,<start_us>,<cost_us>
+ *  which can be compared between two builds by tools/at_boot_prof_diff.py.
+ */
+
+#ifdef CONFIG_AT_BOOT_PROFILER
+/**
+ * @brief Mark the end of a phase, and the start of the next phase.
+ *
+ * @param[in] phase: The name of the phase which ends now, it must be a static string
+ */
+void at_boot_prof_mark(const char *phase);
+
+/**
+ * @brief Print the report of all marked phases.
+ */
+void at_boot_prof_report(void);
+
+#define AT_BOOT_PROF_MARK(phase)            at_boot_prof_mark(phase)
+#define AT_BOOT_PROF_REPORT()               at_boot_prof_report()
+#else
+#define AT_BOOT_PROF_MARK(phase)
+#define AT_BOOT_PROF_REPORT()
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,48 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include "esp_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Deferred AT log
+ *
+ *  esp_at_log_write() only records the log level, the timestamp, the tag and format pointers and the raw arguments
+ *  into a ring buffer, and a low-priority task formats and outputs the records later.
+ *  The tag and the format must be static strings (as the ones passed to ESP_AT_LOGx), the strings of "%s" arguments
+ *  are copied into the record.
+ */
+
+/**
+ * @brief Create the ring buffer and the task which outputs the deferred logs.
+ *
+ * @note The logs are output synchronously before it is called.
+ */
+void at_log_deferred_init(void);
+
+/**
+ * @brief Record a log into the ring buffer.
+ *
+ * @param[in] level: The log level
+ * @param[in] tag: The log tag
+ * @param[in] format: The log format
+ * @param[in] args: The arguments of the format
+ *
+ * @return
+ *      - true: the log is recorded, or dropped because the ring buffer is full
+ *      - false: the deferred log is not available (not initialized or in ISR), the log should be output synchronously
+ */
+bool at_log_deferred_writev(esp_log_level_t level, const char *tag, const char *format, va_list args);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stddef.h>
+#include "esp_err.h"
+#include "nvs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Write-back cache of the AT configurations in NVS
+ *
+ *  esp_at_nvs_set_str() and esp_at_nvs_set_blob() only keep the latest value of each (namespace, key) in RAM,
+ *  and esp_at_nvs_get_str() and esp_at_nvs_get_blob() read the cached value first.
+ *  The cached values are written back with one commit per namespace once the writes have been idle for
+ *  CONFIG_AT_NVS_CACHE_FLUSH_DELAY milliseconds, or by esp_at_nvs_flush(), e.g., AT+USERNVSFLUSH and before restart.
+ *
+ *  The namespace of a handle is tracked by wrapping nvs_open() and nvs_close(). The handles opened by
+ *  nvs_open_from_partition() are not tracked, so that their writes go to NVS directly.
+ *  nvs_erase_key(), nvs_erase_all() and nvs_flash_erase() are wrapped as well to drop the cached values they erase.
+ */
+
+/**
+ * @brief Create the task which writes back the cached values once the writes are idle.
+ *
+ * @note The values are written to NVS directly before it is called.
+ */
+void at_nvs_cache_init(void);
+
+/**
+ * @brief Cache a value of a key.
+ *
+ * @param[in] handle: The handle obtained from nvs_open()
+ * @param[in] key: The key name
+ * @param[in] type: NVS_TYPE_STR or NVS_TYPE_BLOB
+ * @param[in] value: The value to be cached
+ * @param[in] length: The length of the value, including the null terminator for NVS_TYPE_STR
+ *
+ * @return
+ *  - ESP_OK: the value is cached
+ *  - ESP_ERR_NOT_SUPPORTED: the value can not be cached, and it should be written to NVS directly
+ */
+esp_err_t at_nvs_cache_set(nvs_handle_t handle, const char *key, nvs_type_t type, const void *value, size_t length);
+
+/**
+ * @brief Get the cached value of a key, the same semantics of out_value and length as nvs_get_str() and nvs_get_blob().
+ *
+ * @param[in] handle: The handle obtained from nvs_open()
+ * @param[in] key: The key name
+ * @param[in] type: NVS_TYPE_STR or NVS_TYPE_BLOB
+ * @param[out] out_value: The buffer to hold the value, NULL to query the length only
+ * @param[inout] length: The length of out_value, and the length of the value on return
+ *
+ * @return
+ *  - ESP_ERR_NOT_FOUND: the key is not cached, and it should be read from NVS
+ *  - others: the same as nvs_get_str() and nvs_get_blob()
+ */
+esp_err_t at_nvs_cache_get(nvs_handle_t handle, const char *key, nvs_type_t type, void *out_value, size_t *length);
+
+#ifdef __cplusplus
+}
+#endif
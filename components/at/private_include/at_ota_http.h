@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * OTA HTTP response parser
+ *
+ *  An incremental parser of the HTTP/1.x response for the OTA client, the data can be fed in pieces of any size.
+ *  Typical workflow:
+ *      at_ota_http_parser_init() -> [at_ota_http_parse_header()] * N until at_ota_http_header_done()
+ *      -> [at_ota_http_parse_body()] * N until at_ota_http_body_done()
+ *  The body is decoded in place, the chunked framing is removed.
+ */
+
+#define AT_OTA_HTTP_LINE_LEN_MAX            128     /*!< the longer header lines are truncated, only the known headers are parsed */
+
+typedef enum {
+    AT_OTA_HTTP_STATE_STATUS_LINE = 0,      /*!< waiting for the status line */
+    AT_OTA_HTTP_STATE_HEADER,               /*!< waiting for the header lines */
+    AT_OTA_HTTP_STATE_BODY,                 /*!< receiving the body delimited by Content-Length or by closing the connection */
+    AT_OTA_HTTP_STATE_CHUNK_SIZE,           /*!< waiting for the chunk size line */
+    AT_OTA_HTTP_STATE_CHUNK_DATA,           /*!< receiving the chunk data */
+    AT_OTA_HTTP_STATE_CHUNK_DATA_END,       /*!< waiting for the CRLF after the chunk data */
+    AT_OTA_HTTP_STATE_TRAILER,              /*!< waiting for the trailer lines after the last chunk */
+    AT_OTA_HTTP_STATE_DONE,                 /*!< the response is complete */
+} at_ota_http_state_t;
+
+typedef struct {
+    at_ota_http_state_t state;
+    int status_code;                        /*!< the status code of the response */
+    int content_len;                        /*!< the value of Content-Length, -1: no Content-Length */
+    bool chunked;                           /*!< the body is in chunked transfer encoding */
+    bool keep_alive;                        /*!< the connection can be reused for the next request */
+    uint32_t remain_len;                    /*!< the remaining length of the body or of the current chunk */
+    uint32_t line_len;                      /*!< the length of the line being assembled */
+    char line[AT_OTA_HTTP_LINE_LEN_MAX + 1];
+} at_ota_http_parser_t;
+
+/**
+ * @brief Initialize the parser for a new response.
+ *
+ * @param[out] parser: The parser
+ */
+void at_ota_http_parser_init(at_ota_http_parser_t *parser);
+
+/**
+ * @brief Feed the received data into the parser until the header is complete.
+ *
+ * @param[in] parser: The parser
+ * @param[in] data: The received data
+ * @param[in] len: The length of data
+ *
+ * @return
+ *    - >= 0: the length of data consumed by the header, the rest of data belongs to the body
+ *    - < 0: invalid response
+ */
+int at_ota_http_parse_header(at_ota_http_parser_t *parser, const uint8_t *data, int len);
+
+/**
+ * @brief Decode the received body in place.
+ *
+ * @param[in] parser: The parser
+ * @param[in,out] data: The received data, the decoded body is moved to the beginning of it
+ * @param[in] len: The length of data
+ *
+ * @return
+ *    - >= 0: the length of the decoded body, the data after the end of the response is dropped
+ *    - < 0: invalid chunked framing
+ */
+int at_ota_http_parse_body(at_ota_http_parser_t *parser, uint8_t *data, int len);
+
+/**
+ * @brief Get the length of data to read for the body, so that the data of the next response is not read.
+ *
+ * @param[in] parser: The parser
+ * @param[in] max_len: The space to read into
+ *
+ * @return the length of data to read
+ */
+uint32_t at_ota_http_body_read_len(const at_ota_http_parser_t *parser, uint32_t max_len);
+
+/**
+ * @brief Tell the parser that the connection has been closed by the server.
+ *
+ * @param[in] parser: The parser
+ *
+ * @return true if the response is complete, i.e., the body is delimited by closing the connection
+ */
+bool at_ota_http_conn_closed(at_ota_http_parser_t *parser);
+
+/**
+ * @brief Check whether the header has been parsed.
+ */
+static inline bool at_ota_http_header_done(const at_ota_http_parser_t *parser)
+{
+    return parser->state > AT_OTA_HTTP_STATE_HEADER;
+}
+
+/**
+ * @brief Check whether the response is complete.
+ */
+static inline bool at_ota_http_body_done(const at_ota_http_parser_t *parser)
+{
+    return parser->state == AT_OTA_HTTP_STATE_DONE;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * OTA pipeline
+ *
+ *  The downloader (producer) fills the buffers of a ring, and a dedicated flash-writer task (consumer) writes
+ *  the filled buffers into flash, so that the network receiving and the flash erasing/writing overlap.
+ *  Typical workflow:
+ *      at_ota_pipeline_create() -> [at_ota_pipeline_buffer_get() -> fill -> at_ota_pipeline_buffer_commit()] * N
+ *      -> at_ota_pipeline_finish() -> at_ota_pipeline_destroy()
+ */
+
+/**
+ * @brief The function to write a filled buffer into flash, it is called in the flash-writer task.
+ *
+ * @param[in] arg: The argument in at_ota_pipeline_config_t
+ * @param[in] data: The data to write
+ * @param[in] len: The length of data
+ *
+ * @return
+ *    - ESP_OK: succeed
+ *    - others: fail, the following buffers will not be written
+ */
+typedef esp_err_t (*at_ota_pipeline_write_fn_t)(void *arg, const uint8_t *data, uint32_t len);
+
+typedef struct {
+    uint32_t buffer_size;                   /*!< The size of each buffer */
+    uint32_t buffer_num;                    /*!< The number of buffers in the ring, at least 2 */
+    at_ota_pipeline_write_fn_t write_fn;    /*!< The function to write a filled buffer into flash */
+    void *arg;                              /*!< The argument of write_fn */
+} at_ota_pipeline_config_t;
+
+typedef struct {
+    uint32_t download_bytes;                /*!< The bytes committed by the downloader */
+    uint32_t download_ms;                   /*!< The time that the downloader spends in filling the buffers */
+    uint32_t flash_bytes;                   /*!< The bytes written into flash */
+    uint32_t flash_ms;                      /*!< The time that the flash-writer spends in writing the buffers */
+} at_ota_pipeline_stats_t;
+
+typedef struct at_ota_pipeline *at_ota_pipeline_handle_t;
+
+/**
+ * @brief Create the buffer ring and start the flash-writer task.
+ *
+ * @param[in] config: The pointer of at_ota_pipeline_config_t
+ * @param[out] handle: On success, returns the pipeline handle
+ *
+ * @return
+ *    - ESP_OK: succeed
+ *    - others: fail
+ */
+esp_err_t at_ota_pipeline_create(const at_ota_pipeline_config_t *config, at_ota_pipeline_handle_t *handle);
+
+/**
+ * @brief Get a free buffer to fill, it blocks until the flash-writer has released a buffer.
+ *
+ * @note The time between at_ota_pipeline_buffer_get() and at_ota_pipeline_buffer_commit() is counted as the download time.
+ *
+ * @param[in] handle: The pipeline handle
+ * @param[out] size: The size of the buffer
+ *
+ * @return the buffer, or NULL if the flash-writer has failed
+ */
+uint8_t *at_ota_pipeline_buffer_get(at_ota_pipeline_handle_t handle, uint32_t *size);
+
+/**
+ * @brief Hand a filled buffer over to the flash-writer task.
+ *
+ * @param[in] handle: The pipeline handle
+ * @param[in] buffer: The buffer got from at_ota_pipeline_buffer_get()
+ * @param[in] len: The length of data in the buffer, 0 to give the buffer back without writing it
+ *
+ * @return
+ *    - ESP_OK: succeed
+ *    - others: the flash-writer has failed
+ */
+esp_err_t at_ota_pipeline_buffer_commit(at_ota_pipeline_handle_t handle, uint8_t *buffer, uint32_t len);
+
+/**
+ * @brief Wait for all the committed buffers to be written into flash.
+ *
+ * @param[in] handle: The pipeline handle
+ *
+ * @return
+ *    - ESP_OK: all the buffers are written
+ *    - others: the first error from the write function
+ */
+esp_err_t at_ota_pipeline_finish(at_ota_pipeline_handle_t handle);
+
+/**
+ * @brief Get the download and flash statistics of the pipeline.
+ *
+ * @param[in] handle: The pipeline handle
+ * @param[out] stats: The pointer of at_ota_pipeline_stats_t
+ */
+void at_ota_pipeline_stats_get(at_ota_pipeline_handle_t handle, at_ota_pipeline_stats_t *stats);
+
+/**
+ * @brief Stop the flash-writer task and free the buffer ring.
+ *
+ * @param[in] handle: The pipeline handle
+ */
+void at_ota_pipeline_destroy(at_ota_pipeline_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
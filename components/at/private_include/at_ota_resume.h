@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Resumable OTA
+ *
+ *  The download progress is recorded in NVS while the image is being written. If the download is interrupted,
+ *  the next download of the same image (the same source and the same partition) requests the missing range only
+ *  by "Range: bytes=<offset>-", and continues writing from the recorded offset.
+ *  The recorded offset is aligned down to the flash sector size, so that the sector being written when the download
+ *  was interrupted is erased and written again.
+ */
+
+#define AT_OTA_RESUME_SAVE_INTERVAL         (64 * 1024)     /*!< the progress is saved to NVS every so many bytes */
+
+typedef struct {
+    bool enabled;                           /*!< false if the partition can not be resumed, e.g., it is encrypted */
+    uint32_t id;                            /*!< the identity of the download source */
+    const esp_partition_t *partition;       /*!< the partition to write */
+    uint32_t total_len;                     /*!< the total length of the image */
+    uint32_t saved_len;                     /*!< the written length saved to NVS last time */
+} at_ota_resume_t;
+
+/**
+ * @brief Look up the download progress of an image.
+ *
+ * @param[out] resume: The resume context
+ * @param[in] source: The string which identifies the image, e.g., the url or the http request line
+ * @param[in] partition: The partition to write
+ *
+ * @return the sector-aligned offset to resume from, 0 if the image has to be downloaded from the beginning
+ */
+uint32_t at_ota_resume_lookup(at_ota_resume_t *resume, const char *source, const esp_partition_t *partition);
+
+/**
+ * @brief Start to record the download progress.
+ *
+ * @note If the download starts from the beginning, the previous record is cleared, so call it before the partition is erased.
+ *
+ * @param[in] resume: The resume context
+ * @param[in] offset: The offset that the download starts from
+ * @param[in] total_len: The total length of the image, 0: unknown, the progress is not recorded
+ */
+void at_ota_resume_start(at_ota_resume_t *resume, uint32_t offset, uint32_t total_len);
+
+/**
+ * @brief Update the download progress, it is saved to NVS every AT_OTA_RESUME_SAVE_INTERVAL bytes.
+ *
+ * @param[in] resume: The resume context
+ * @param[in] written_len: The length of data which has been written into the partition
+ */
+void at_ota_resume_update(at_ota_resume_t *resume, uint32_t written_len);
+
+/**
+ * @brief Clear the download progress, it is called when the image is complete or invalid.
+ */
+void at_ota_resume_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,82 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#ifdef CONFIG_AT_BOOT_PROFILER
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#include "at_boot_prof.h"
+
+#define AT_BOOT_PROF_PHASE_MAX              48
+
+typedef struct {
+    const char *phase;
+    uint32_t start_us;                      // the start time of the phase since boot
+    uint32_t cost_us;
+} at_boot_prof_phase_t;
+
+// static variables
+static at_boot_prof_phase_t s_phases[AT_BOOT_PROF_PHASE_MAX];
+static uint8_t s_phase_num;
+static uint8_t s_phase_dropped;
+static int64_t s_last_mark_us;
+static const char *TAG = "at-boot-prof";
+
+void at_boot_prof_mark(const char *phase)
+{
+    int64_t now = esp_timer_get_time();
+
+    if (s_phase_num < AT_BOOT_PROF_PHASE_MAX) {
+        s_phases[s_phase_num].phase = phase;
+        s_phases[s_phase_num].start_us = s_last_mark_us;
+        s_phases[s_phase_num].cost_us = now - s_last_mark_us;
+        s_phase_num++;
+    } else {
+        s_phase_dropped++;
+    }
+
+    // exclude the time spent on profiling itself
+    s_last_mark_us = esp_timer_get_time();
+}
+
+void at_boot_prof_report(void)
+{
+    uint8_t order[AT_BOOT_PROF_PHASE_MAX];
+    uint32_t total_us = 0;
+
+    for (uint8_t i = 0; i < s_phase_num; i++) {
+        order[i] = i;
+        total_us += s_phases[i].cost_us;
+    }
+    // insertion sort by cost, the most expensive phase first
+    for (uint8_t i = 1; i < s_phase_num; i++) {
+        uint8_t cur = order[i];
+        int j = i - 1;
+        while (j >= 0 && s_phases[order[j]].cost_us < s_phases[cur].cost_us) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = cur;
+    }
+
+    ESP_LOGI(TAG, "ready in %u us (wakeup cause: %d), %u phases:", total_us, esp_sleep_get_wakeup_cause(), s_phase_num);
+    for (uint8_t i = 0; i < s_phase_num; i++) {
+        const at_boot_prof_phase_t *p = &s_phases[order[i]];
+        ESP_LOGI(TAG, "%8u us %3u%% %s", p->cost_us, total_us ? (uint32_t)((uint64_t)p->cost_us * 100 / total_us) : 0, p->phase);
+    }
+    if (s_phase_dropped) {
+        ESP_LOGW(TAG, "%u phases are not recorded, please enlarge AT_BOOT_PROF_PHASE_MAX", s_phase_dropped);
+    }
+
+    // the machine-readable dump in the marked order, see tools/at_boot_prof_diff.py
+    for (uint8_t i = 0; i < s_phase_num; i++) {
+        printf("AT_BOOT_PROF,%s,%u,%u\n", s_phases[i].phase, s_phases[i].start_us, s_phases[i].cost_us);
+    }
+}
+#endif
@@ -11,6 +11,7 @@
 #include "esp_at_core.h"
 #include "esp_at.h"
 #include "esp_at_interface.h"
+#include "at_boot_prof.h"
 
 static const char *TAG = "at-cmd-register";
 
@@ -108,6 +109,7 @@ void esp_at_cmd_set_register(void)
         } else {
             ESP_LOGD(TAG, "%s success", p->name);
         }
+        AT_BOOT_PROF_MARK(p->name);
     }
 
     // register the at command set which initialized by ESP_AT_CMD_SET_INIT_FN
@@ -120,6 +122,7 @@ void esp_at_cmd_set_register(void)
         } else {
             ESP_LOGD(TAG, "%s success", p->name);
         }
+        AT_BOOT_PROF_MARK(p->name);
     }
 
     // register the at command set which initialized by ESP_AT_CMD_SET_LAST_INIT_FN
@@ -132,5 +135,6 @@ void esp_at_cmd_set_register(void)
         } else {
             ESP_LOGD(TAG, "%s success", p->name);
         }
+        AT_BOOT_PROF_MARK(p->name);
     }
 }
@@ -7,6 +7,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/param.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -19,39 +20,105 @@
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_partition.h"
+#include "spi_flash_mmap.h"
 #include "bootloader_custom_ota.h"
 #include "at_compress_ota.h"
+#ifdef CONFIG_AT_OTA_RESUME_SUPPORT
+#include "at_ota_resume.h"
+#endif
 
 #define AT_COMPRESSED_IMAGE_MAGIC_NUMBER        BOOTLOADER_CUSTOM_OTA_HEADER_MAGIC
 #define AT_COMPRESS_OTA_PARTITION_SUBTYPE       BOOTLOADER_CUSTOM_OTA_PARTITION_SUBTYPE
 #define AT_HEAP_BUFFER_SIZE                     4096
+#define AT_HTTP_STATUS_PARTIAL_CONTENT          206
+#define AT_COMPRESS_OTA_ERASE_BLOCK_SIZE        (64 * 1024)
+#define AT_COMPRESS_OTA_ALIGN_UP(x, align)      (((x) + (align) - 1) & ~((align) - 1))
 
 static const char *TAG = "compress-ota";
 
-esp_err_t at_compress_ota_begin(at_compress_ota_handle_t *handle)
-{
-    if (!handle) {
-        return ESP_FAIL;
-    }
+static esp_err_t at_compress_image_header_check(at_compress_ota_handle_t *handle, bootloader_custom_ota_header_t *compressed_img_header);
+static esp_err_t at_compress_image_body_read_digest(at_compress_ota_handle_t *handle, uint32_t start, uint32_t end, md5_context_t *md5_context);
 
+const esp_partition_t *at_compress_ota_partition_get(void)
+{
     const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, AT_COMPRESS_OTA_PARTITION_SUBTYPE, NULL);
     if (partition) {
         ESP_LOGD(TAG, "Found partition, offset:0x%x size:0x%x", partition->address, partition->size);
     } else {
         ESP_LOGE(TAG, "No partition, type:%d subtype:%d", ESP_PARTITION_TYPE_DATA, AT_COMPRESS_OTA_PARTITION_SUBTYPE);
+    }
+
+    return partition;
+}
+
+esp_err_t at_compress_ota_begin(at_compress_ota_handle_t *handle)
+{
+    return at_compress_ota_begin_with_offset(handle, 0);
+}
+
+esp_err_t at_compress_ota_begin_with_offset(at_compress_ota_handle_t *handle, uint32_t offset)
+{
+    if (!handle) {
         return ESP_FAIL;
     }
 
-    esp_err_t ret = esp_partition_erase_range(partition, 0, partition->size);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to erase partition: %s", esp_err_to_name(ret));
+    const esp_partition_t *partition = at_compress_ota_partition_get();
+    if (!partition) {
         return ESP_FAIL;
     }
 
-    handle->wrote_size = 0;
+    if ((offset % SPI_FLASH_SEC_SIZE) || offset >= partition->size) {
+        ESP_LOGE(TAG, "Invalid offset:0x%x", offset);
+        return ESP_FAIL;
+    }
+
+    handle->wrote_size = offset;
+    handle->erased_size = offset;
+    handle->header_len = 0;
     handle->compressed_img_size = 0;
     handle->image_header_checked = false;
     handle->partition = partition;
+    esp_rom_md5_init(&handle->md5_context);
+
+    if (offset > 0) {
+        // the header has been written before the download was interrupted, check it again
+        bootloader_custom_ota_header_t compressed_img_header;
+        if (offset < sizeof(compressed_img_header)
+                || esp_partition_read(partition, 0, &compressed_img_header, sizeof(compressed_img_header)) != ESP_OK
+                || at_compress_image_header_check(handle, &compressed_img_header) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to resume compressed image at 0x%x", offset);
+            return ESP_FAIL;
+        }
+
+        // the body which has been written is not streamed through the digest, read it back once
+        if (at_compress_image_body_read_digest(handle, sizeof(compressed_img_header), offset, &handle->md5_context) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+
+    // the partition is erased sector by sector ahead of the writes, see at_compress_ota_erase_ahead()
+    return ESP_OK;
+}
+
+static esp_err_t at_compress_ota_erase_ahead(at_compress_ota_handle_t *handle, uint32_t end)
+{
+    if (end <= handle->erased_size) {
+        return ESP_OK;
+    }
+
+    uint32_t erase_end = AT_COMPRESS_OTA_ALIGN_UP(end, SPI_FLASH_SEC_SIZE);
+    if (handle->image_header_checked) {
+        // erase up to the next 64 KB boundary within the image, so that the flash can erase a whole block at once
+        uint32_t image_end = AT_COMPRESS_OTA_ALIGN_UP(handle->compressed_img_size, SPI_FLASH_SEC_SIZE);
+        erase_end = MAX(erase_end, MIN(AT_COMPRESS_OTA_ALIGN_UP(end, AT_COMPRESS_OTA_ERASE_BLOCK_SIZE), image_end));
+    }
+    end = MIN(erase_end, handle->partition->size);
+    esp_err_t ret = esp_partition_erase_range(handle->partition, handle->erased_size, end - handle->erased_size);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to erase partition: %s", esp_err_to_name(ret));
+        return ESP_FAIL;
+    }
+    handle->erased_size = end;
 
     return ESP_OK;
 }
@@ -98,9 +165,14 @@ static esp_err_t at_compress_image_header_check(at_compress_ota_handle_t *handle
     return ESP_OK;
 }
 
-static esp_err_t at_compress_image_body_check(at_compress_ota_handle_t *handle, bootloader_custom_ota_header_t *compressed_img_header)
+static esp_err_t at_compress_image_body_read_digest(at_compress_ota_handle_t *handle, uint32_t start, uint32_t end, md5_context_t *md5_context)
 {
-    esp_err_t ret = ESP_FAIL;
+    esp_err_t ret = ESP_OK;
+
+    end = MIN(end, handle->compressed_img_size);
+    if (start >= end) {
+        return ESP_OK;
+    }
 
     uint8_t *data = (uint8_t *)malloc(AT_HEAP_BUFFER_SIZE);
     if (!data) {
@@ -109,34 +181,75 @@ static esp_err_t at_compress_image_body_check(at_compress_ota_handle_t *handle,
     }
 
     uint32_t had_read_len = 0;
-    uint32_t img_body_len = compressed_img_header->length;
-    uint32_t head_len = sizeof(bootloader_custom_ota_header_t);
-
-    md5_context_t md5_context;
-    esp_rom_md5_init(&md5_context);
+    uint32_t read_len = end - start;
     do {
-        int to_read_len = (img_body_len - had_read_len > AT_HEAP_BUFFER_SIZE) ? AT_HEAP_BUFFER_SIZE : (img_body_len - had_read_len);
-        ret = esp_partition_read(handle->partition, head_len + had_read_len, data, to_read_len);
+        int to_read_len = (read_len - had_read_len > AT_HEAP_BUFFER_SIZE) ? AT_HEAP_BUFFER_SIZE : (read_len - had_read_len);
+        ret = esp_partition_read(handle->partition, start + had_read_len, data, to_read_len);
         if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to read compressed image: %s", esp_err_to_name(ret));
             break;
         }
-        esp_rom_md5_update(&md5_context, data, to_read_len);
+        esp_rom_md5_update(md5_context, data, to_read_len);
         had_read_len += to_read_len;
-    } while (ret == ESP_OK && had_read_len < img_body_len);
+    } while (ret == ESP_OK && had_read_len < read_len);
+
+    free(data);
+    return ret;
+}
+
+static void at_compress_image_body_digest_update(at_compress_ota_handle_t *handle, uint32_t offset, const uint8_t *data, int size)
+{
+    // only the body is covered by the digest, neither the header nor the padding after the image
+    uint32_t start = MAX(offset, sizeof(bootloader_custom_ota_header_t));
+    uint32_t end = MIN(offset + size, handle->compressed_img_size);
+    if (start < end) {
+        esp_rom_md5_update(&handle->md5_context, data + (start - offset), end - start);
+    }
+}
+
+#ifdef CONFIG_AT_COMPRESS_OTA_FLASH_VERIFY
+static esp_err_t at_compress_image_body_check(at_compress_ota_handle_t *handle, bootloader_custom_ota_header_t *compressed_img_header)
+{
+    md5_context_t md5_context;
+    esp_rom_md5_init(&md5_context);
+    if (at_compress_image_body_read_digest(handle, sizeof(bootloader_custom_ota_header_t), handle->compressed_img_size, &md5_context) != ESP_OK) {
+        return ESP_FAIL;
+    }
 
     uint8_t digest[16] = {0};
     esp_rom_md5_final(digest, &md5_context);
 
-    if (!memcmp(compressed_img_header->md5, digest, sizeof(digest))) {
-        ESP_LOGD(TAG, "Compressed image MD5 check succeeded");
-        ret = ESP_OK;
+    if (memcmp(compressed_img_header->md5, digest, sizeof(digest))) {
+        ESP_LOGE(TAG, "Compressed image MD5 check of flash failed");
+        return ESP_FAIL;
+    }
+    ESP_LOGD(TAG, "Compressed image MD5 check of flash succeeded");
+
+    return ESP_OK;
+}
+#endif
+
+static esp_err_t at_compress_ota_flash_write(at_compress_ota_handle_t *handle, const uint8_t *data, int size)
+{
+    if (handle->wrote_size + size > handle->partition->size) {
+        ESP_LOGE(TAG, "Compressed image overlength, image size:%d > psize:%d", handle->wrote_size + size, handle->partition->size);
+        return ESP_FAIL;
+    }
+
+    if (at_compress_ota_erase_ahead(handle, handle->wrote_size + size) != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = esp_partition_write(handle->partition, handle->wrote_size, data, size);
+    if (ret == ESP_OK) {
+        at_compress_image_body_digest_update(handle, handle->wrote_size, data, size);
+        handle->wrote_size += size;
     } else {
-        ESP_LOGE(TAG, "Compressed image MD5 check failed");
-        ret = ESP_FAIL;
+        ESP_LOGE(TAG, "Failed to write compressed image: %s", esp_err_to_name(ret));
+        return ESP_FAIL;
     }
 
-    free(data);
-    return ret;
+    return ESP_OK;
 }
 
 esp_err_t at_compress_ota_write(at_compress_ota_handle_t *handle, const void *data, int size)
@@ -146,31 +259,32 @@ esp_err_t at_compress_ota_write(at_compress_ota_handle_t *handle, const void *da
         return ESP_FAIL;
     }
 
-    if (size < 0) {
-        return ESP_OK;
-    }
-
+    const uint8_t *p = (const uint8_t *)data;
     if (!handle->image_header_checked) {
+        // stage the header until it is complete, so that the data can be fed in chunks of any size
         uint32_t head_len = sizeof(bootloader_custom_ota_header_t);
-        if (size >= head_len) {
-            if (at_compress_image_header_check(handle, (bootloader_custom_ota_header_t *)data) != ESP_OK) {
-                return ESP_FAIL;
-            }
-        } else {
-            ESP_LOGE(TAG, "Recv insufficient header: %d", size);
+        uint32_t copy_len = MIN(head_len - handle->header_len, size);
+        memcpy((uint8_t *)&handle->header + handle->header_len, p, copy_len);
+        handle->header_len += copy_len;
+        p += copy_len;
+        size -= copy_len;
+        if (handle->header_len < head_len) {
+            return ESP_OK;
+        }
+
+        if (at_compress_image_header_check(handle, &handle->header) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        if (at_compress_ota_flash_write(handle, (const uint8_t *)&handle->header, head_len) != ESP_OK) {
             return ESP_FAIL;
         }
     }
 
-    esp_err_t ret = esp_partition_write(handle->partition, handle->wrote_size, data, size);
-    if (ret == ESP_OK) {
-        handle->wrote_size += size;
-    } else {
-        ESP_LOGE(TAG, "Failed to write compressed image: %s", esp_err_to_name(ret));
-        return ESP_FAIL;
+    if (size == 0) {
+        return ESP_OK;
     }
 
-    return ESP_OK;
+    return at_compress_ota_flash_write(handle, p, size);
 }
 
 esp_err_t at_compress_ota_end(at_compress_ota_handle_t *handle)
@@ -179,6 +293,11 @@ esp_err_t at_compress_ota_end(at_compress_ota_handle_t *handle)
         return ESP_FAIL;
     }
 
+    if (!handle->image_header_checked) {
+        ESP_LOGE(TAG, "Recv insufficient header: %d", handle->header_len);
+        return ESP_FAIL;
+    }
+
     if (handle->wrote_size < handle->compressed_img_size) {
         ESP_LOGE(TAG, "Unmatched compressed image size (expected:%d, saw:%d)", handle->compressed_img_size, handle->wrote_size);
         return ESP_FAIL;
@@ -196,10 +315,20 @@ esp_err_t at_compress_ota_end(at_compress_ota_handle_t *handle)
         return ESP_FAIL;
     }
 
-    // check compressed image body
+    // check compressed image body by the digest computed while it was being written
+    uint8_t digest[16] = {0};
+    esp_rom_md5_final(digest, &handle->md5_context);
+    if (memcmp(compressed_img_header.md5, digest, sizeof(digest))) {
+        ESP_LOGE(TAG, "Compressed image MD5 check failed");
+        return ESP_FAIL;
+    }
+
+#ifdef CONFIG_AT_COMPRESS_OTA_FLASH_VERIFY
+    // read the image back to make sure that the flash holds what has been downloaded
     if (at_compress_image_body_check(handle, &compressed_img_header) != ESP_OK) {
         return ESP_FAIL;
     }
+#endif
     ESP_LOGI(TAG, "Compressed image integrity verification succeeded!");
 
     return ESP_OK;
@@ -211,10 +340,11 @@ esp_err_t at_compress_https_ota(const esp_http_client_config_t *config)
         return ESP_FAIL;
     }
 
-    at_compress_ota_handle_t handle;
-    if (at_compress_ota_begin(&handle) != ESP_OK) {
-        return ESP_FAIL;
-    }
+    uint32_t offset = 0;
+#ifdef CONFIG_AT_OTA_RESUME_SUPPORT
+    at_ota_resume_t resume;
+    offset = at_ota_resume_lookup(&resume, config->url, at_compress_ota_partition_get());
+#endif
 
     esp_http_client_handle_t client = esp_http_client_init(config);
     if (client == NULL) {
@@ -222,6 +352,12 @@ esp_err_t at_compress_https_ota(const esp_http_client_config_t *config)
         return ESP_FAIL;
     }
 
+    if (offset > 0) {
+        char range[32];
+        snprintf(range, sizeof(range), "bytes=%u-", offset);
+        esp_http_client_set_header(client, "Range", range);
+    }
+
     esp_err_t ret = esp_http_client_open(client, 0);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to open HTTP connection: %s", esp_err_to_name(ret));
@@ -229,15 +365,38 @@ esp_err_t at_compress_https_ota(const esp_http_client_config_t *config)
         return ESP_FAIL;
     }
 
-    esp_http_client_fetch_headers(client);
+    int content_len = (int)esp_http_client_fetch_headers(client);
     int status_code = esp_http_client_get_status_code(client);
     if (status_code >= HttpStatus_BadRequest) {
         ESP_LOGE(TAG, "HTTP client error (%d)", status_code);
+        esp_http_client_cleanup(client);
+        return ESP_FAIL;
+    }
+
+    if (status_code != AT_HTTP_STATUS_PARTIAL_CONTENT) {
+        // the server ignores the range, download the whole image
+        offset = 0;
+    }
+#ifdef CONFIG_AT_OTA_RESUME_SUPPORT
+    else if (content_len <= 0 || offset + content_len != resume.total_len) {
+        // the image on the server has been changed since the download was interrupted
+        ESP_LOGE(TAG, "Unmatched image size (expected:%d, saw:%d)", resume.total_len, offset + content_len);
+        at_ota_resume_clear();
+        esp_http_client_cleanup(client);
+        return ESP_FAIL;
+    }
+    at_ota_resume_start(&resume, offset, content_len > 0 ? offset + content_len : 0);
+#endif
+
+    at_compress_ota_handle_t handle;
+    if (at_compress_ota_begin_with_offset(&handle, offset) != ESP_OK) {
+        esp_http_client_cleanup(client);
         return ESP_FAIL;
     }
 
     uint8_t *data = (uint8_t *)malloc(AT_HEAP_BUFFER_SIZE);
     if (!data) {
+        esp_http_client_cleanup(client);
         return ESP_FAIL;
     }
 
@@ -249,6 +408,9 @@ esp_err_t at_compress_https_ota(const esp_http_client_config_t *config)
             if (ret != ESP_OK) {
                 break;
             }
+#ifdef CONFIG_AT_OTA_RESUME_SUPPORT
+            at_ota_resume_update(&resume, handle.wrote_size);
+#endif
         } else if (data_len < 0) {
             ESP_LOGE(TAG, "Connection aborted");
             break;
@@ -258,7 +420,17 @@ esp_err_t at_compress_https_ota(const esp_http_client_config_t *config)
     esp_http_client_cleanup(client);
     free(data);
 
-    return (ret == ESP_OK ? at_compress_ota_end(&handle) : ret);
+    if (ret == ESP_OK) {
+        ret = at_compress_ota_end(&handle);
+#ifdef CONFIG_AT_OTA_RESUME_SUPPORT
+        // keep the progress of an incomplete image, so that it can be resumed next time
+        if (ret == ESP_OK || handle.wrote_size >= handle.compressed_img_size) {
+            at_ota_resume_clear();
+        }
+#endif
+    }
+
+    return ret;
 }
 
 #endif
@@ -18,6 +18,12 @@
 #include "esp_bt.h"
 #endif
 #include "at_ota.h"
+#ifdef CONFIG_AT_LOG_DEFERRED
+#include "at_log_deferred.h"
+#endif
+#ifdef CONFIG_AT_NVS_WRITE_BACK_CACHE
+#include "at_nvs_cache.h"
+#endif
 
 // unknown module name if not defined
 #define ESP_AT_UNKNOWN_STR      "Unknown"
@@ -127,21 +133,43 @@ void esp_at_set_module_id_by_str(const char *buffer)
  *********************************************************************/
 __attribute__((weak)) esp_err_t esp_at_nvs_set_str(nvs_handle_t handle, const char *key, const char *value)
 {
+#ifdef CONFIG_AT_NVS_WRITE_BACK_CACHE
+    if (value && at_nvs_cache_set(handle, key, NVS_TYPE_STR, value, strlen(value) + 1) == ESP_OK) {
+        return ESP_OK;
+    }
+#endif
     return nvs_set_str(handle, key, value);
 }
 
 __attribute__((weak)) esp_err_t esp_at_nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length)
 {
+#ifdef CONFIG_AT_NVS_WRITE_BACK_CACHE
+    esp_err_t ret = at_nvs_cache_get(handle, key, NVS_TYPE_STR, out_value, length);
+    if (ret != ESP_ERR_NOT_FOUND) {
+        return ret;
+    }
+#endif
     return nvs_get_str(handle, key, out_value, length);
 }
 
 __attribute__((weak)) esp_err_t esp_at_nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
 {
+#ifdef CONFIG_AT_NVS_WRITE_BACK_CACHE
+    if ((value || !length) && at_nvs_cache_set(handle, key, NVS_TYPE_BLOB, value, length) == ESP_OK) {
+        return ESP_OK;
+    }
+#endif
     return nvs_set_blob(handle, key, value, length);
 }
 
 __attribute__((weak)) esp_err_t esp_at_nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
 {
+#ifdef CONFIG_AT_NVS_WRITE_BACK_CACHE
+    esp_err_t ret = at_nvs_cache_get(handle, key, NVS_TYPE_BLOB, out_value, length);
+    if (ret != ESP_ERR_NOT_FOUND) {
+        return ret;
+    }
+#endif
     return nvs_get_blob(handle, key, out_value, length);
 }
 
@@ -151,6 +179,13 @@ __attribute__((weak)) void esp_at_log_write(esp_log_level_t level, const char *t
         char level_str[ESP_LOG_MAX] = {'N', 'E', 'W', 'I', 'D', 'V'};
         va_list list;
         va_start(list, format);
+#ifdef CONFIG_AT_LOG_DEFERRED
+        // only record the log on the hot path, the low-priority log task formats and outputs it later
+        if (at_log_deferred_writev(level, tag, format, list)) {
+            va_end(list);
+            return;
+        }
+#endif
         size_t new_format_length = strlen(tag) + strlen(format) + 30;
         char new_format[new_format_length];
         snprintf(new_format, new_format_length, "%c (%"PRIu32") %s: %s\n", level_str[level], esp_log_timestamp(), tag, format);
@@ -0,0 +1,447 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/param.h>
+#include "sdkconfig.h"
+
+#ifdef CONFIG_AT_DELTA_OTA_SUPPORT
+#include "esp_http_client.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_rom_md5.h"
+#include "at_delta_ota.h"
+
+#define AT_DELTA_OTA_BUFFER_SIZE                4096
+
+typedef enum {
+    AT_DELTA_OTA_STATE_HEADER = 0,          // receiving the delta image header
+    AT_DELTA_OTA_STATE_OP,                  // receiving the op header
+    AT_DELTA_OTA_STATE_INSERT,              // receiving the new data of AT_DELTA_OTA_OP_INSERT
+    AT_DELTA_OTA_STATE_DIFF_RECORD,         // receiving the record header of AT_DELTA_OTA_OP_DIFF
+    AT_DELTA_OTA_STATE_DIFF_DATA,           // receiving the new data of a diff record
+    AT_DELTA_OTA_STATE_DONE,                // the new firmware has been rebuilt
+} at_delta_ota_state_t;
+
+static const char *TAG = "delta-ota";
+
+esp_err_t at_delta_ota_begin(at_delta_ota_handle_t *handle)
+{
+    if (!handle) {
+        return ESP_FAIL;
+    }
+    memset(handle, 0, sizeof(at_delta_ota_handle_t));
+
+    handle->src_partition = esp_ota_get_running_partition();
+    handle->dst_partition = esp_ota_get_next_update_partition(NULL);
+    if (!handle->src_partition || !handle->dst_partition) {
+        ESP_LOGE(TAG, "No update partition");
+        return ESP_FAIL;
+    }
+    ESP_LOGD(TAG, "Delta from partition:%s to partition:%s", handle->src_partition->label, handle->dst_partition->label);
+
+    handle->buffer = (uint8_t *)malloc(AT_DELTA_OTA_BUFFER_SIZE);
+    if (!handle->buffer) {
+        ESP_LOGE(TAG, "malloc failed");
+        return ESP_FAIL;
+    }
+    handle->state = AT_DELTA_OTA_STATE_HEADER;
+    esp_rom_md5_init(&handle->md5_context);
+
+    return ESP_OK;
+}
+
+static esp_err_t at_delta_ota_flush(at_delta_ota_handle_t *handle)
+{
+    if (handle->buffer_len == 0) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = esp_ota_write(handle->ota_handle, handle->buffer, handle->buffer_len);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write new firmware: %s", esp_err_to_name(ret));
+        return ESP_FAIL;
+    }
+    handle->buffer_len = 0;
+
+    return ESP_OK;
+}
+
+static esp_err_t at_delta_ota_output(at_delta_ota_handle_t *handle, const uint8_t *data, uint32_t len)
+{
+    while (len > 0) {
+        uint32_t copy_len = MIN(len, AT_DELTA_OTA_BUFFER_SIZE - handle->buffer_len);
+        memcpy(handle->buffer + handle->buffer_len, data, copy_len);
+        esp_rom_md5_update(&handle->md5_context, data, copy_len);
+        handle->buffer_len += copy_len;
+        handle->wrote_size += copy_len;
+        data += copy_len;
+        len -= copy_len;
+
+        if (handle->buffer_len == AT_DELTA_OTA_BUFFER_SIZE && at_delta_ota_flush(handle) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t at_delta_ota_output_src(at_delta_ota_handle_t *handle, uint32_t len)
+{
+    // read the running firmware into the buffer directly
+    while (len > 0) {
+        uint32_t read_len = MIN(len, AT_DELTA_OTA_BUFFER_SIZE - handle->buffer_len);
+        uint8_t *data = handle->buffer + handle->buffer_len;
+        esp_err_t ret = esp_partition_read(handle->src_partition, handle->src_offset, data, read_len);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to read running firmware: %s", esp_err_to_name(ret));
+            return ESP_FAIL;
+        }
+        esp_rom_md5_update(&handle->md5_context, data, read_len);
+        handle->buffer_len += read_len;
+        handle->wrote_size += read_len;
+        handle->src_offset += read_len;
+        handle->op_remain -= read_len;
+        len -= read_len;
+
+        if (handle->buffer_len == AT_DELTA_OTA_BUFFER_SIZE && at_delta_ota_flush(handle) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t at_delta_ota_header_check(at_delta_ota_handle_t *handle)
+{
+    at_delta_ota_header_t *header = &handle->header;
+
+    if (memcmp(header->magic, AT_DELTA_OTA_MAGIC, sizeof(header->magic))) {
+        ESP_LOGE(TAG, "Delta image has invalid magic bytes (expected:%s, saw:%.*s)", AT_DELTA_OTA_MAGIC, sizeof(header->magic), header->magic);
+        return ESP_FAIL;
+    }
+    if (header->version != AT_DELTA_OTA_VERSION || header->header_len != sizeof(at_delta_ota_header_t)) {
+        ESP_LOGE(TAG, "Delta image has invalid header version (expected:%d, saw:%d)", AT_DELTA_OTA_VERSION, header->version);
+        return ESP_FAIL;
+    }
+    if (header->src_size > handle->src_partition->size || header->dst_size > handle->dst_partition->size) {
+        ESP_LOGE(TAG, "Delta image overlength, src:%d dst:%d", header->src_size, header->dst_size);
+        return ESP_FAIL;
+    }
+
+    // the delta can be applied to the firmware which it is generated from only
+    md5_context_t md5_context;
+    esp_rom_md5_init(&md5_context);
+    handle->src_offset = 0;
+    while (handle->src_offset < header->src_size) {
+        uint32_t read_len = MIN(header->src_size - handle->src_offset, AT_DELTA_OTA_BUFFER_SIZE);
+        if (esp_partition_read(handle->src_partition, handle->src_offset, handle->buffer, read_len) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        esp_rom_md5_update(&md5_context, handle->buffer, read_len);
+        handle->src_offset += read_len;
+    }
+    uint8_t digest[16] = {0};
+    esp_rom_md5_final(digest, &md5_context);
+    if (memcmp(digest, header->src_md5, sizeof(digest))) {
+        ESP_LOGE(TAG, "Delta image does not match the running firmware");
+        return ESP_FAIL;
+    }
+
+    // only the size of the new firmware is erased
+    esp_err_t ret = esp_ota_begin(handle->dst_partition, header->dst_size, &handle->ota_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_begin failed: %s", esp_err_to_name(ret));
+        handle->ota_handle = 0;
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t at_delta_ota_src_check(at_delta_ota_handle_t *handle, uint32_t offset, uint32_t len)
+{
+    if (offset > handle->header.src_size || len > handle->header.src_size - offset) {
+        ESP_LOGE(TAG, "Invalid source range, offset:0x%x len:%d", offset, len);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t at_delta_ota_op_start(at_delta_ota_handle_t *handle)
+{
+    at_delta_ota_op_t *op = &handle->op;
+    memcpy(op, handle->stage, sizeof(at_delta_ota_op_t));
+
+    if (op->len == 0 || op->len > handle->header.dst_size - handle->wrote_size) {
+        ESP_LOGE(TAG, "Invalid op length:%d", op->len);
+        return ESP_FAIL;
+    }
+    handle->op_remain = op->len;
+    handle->src_offset = op->src_offset;
+
+    switch (op->type) {
+    case AT_DELTA_OTA_OP_COPY:
+        if (at_delta_ota_src_check(handle, op->src_offset, op->len) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        if (at_delta_ota_output_src(handle, op->len) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        handle->state = AT_DELTA_OTA_STATE_OP;
+        break;
+    case AT_DELTA_OTA_OP_INSERT:
+        handle->state = AT_DELTA_OTA_STATE_INSERT;
+        break;
+    case AT_DELTA_OTA_OP_DIFF:
+        if (at_delta_ota_src_check(handle, op->src_offset, op->len) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        handle->state = AT_DELTA_OTA_STATE_DIFF_RECORD;
+        break;
+    default:
+        ESP_LOGE(TAG, "Invalid op type:%d", op->type);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t at_delta_ota_diff_record_start(at_delta_ota_handle_t *handle)
+{
+    uint16_t same_len = handle->stage[0] | (handle->stage[1] << 8);
+    uint16_t diff_len = handle->stage[2] | (handle->stage[3] << 8);
+
+    if ((uint32_t)same_len + diff_len > handle->op_remain || (same_len + diff_len) == 0) {
+        ESP_LOGE(TAG, "Invalid diff record, same:%d diff:%d remain:%d", same_len, diff_len, handle->op_remain);
+        return ESP_FAIL;
+    }
+
+    if (at_delta_ota_output_src(handle, same_len) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    handle->diff_remain = diff_len;
+    handle->state = diff_len ? AT_DELTA_OTA_STATE_DIFF_DATA : AT_DELTA_OTA_STATE_DIFF_RECORD;
+
+    return ESP_OK;
+}
+
+static void at_delta_ota_op_end_check(at_delta_ota_handle_t *handle)
+{
+    if (handle->state == AT_DELTA_OTA_STATE_DIFF_RECORD && handle->op_remain > 0) {
+        return;
+    }
+    if (handle->state == AT_DELTA_OTA_STATE_INSERT || handle->state == AT_DELTA_OTA_STATE_DIFF_DATA) {
+        return;
+    }
+    handle->state = (handle->wrote_size == handle->header.dst_size) ? AT_DELTA_OTA_STATE_DONE : AT_DELTA_OTA_STATE_OP;
+}
+
+/**
+ * @brief Stage the fixed-length fields which may be split across the writes.
+ *
+ * @return the length of data consumed
+ */
+static uint32_t at_delta_ota_stage(at_delta_ota_handle_t *handle, void *dst, uint32_t need, const uint8_t *data, uint32_t len)
+{
+    uint32_t copy_len = MIN(need - handle->stage_len, len);
+    memcpy((uint8_t *)dst + handle->stage_len, data, copy_len);
+    handle->stage_len += copy_len;
+    return copy_len;
+}
+
+esp_err_t at_delta_ota_write(at_delta_ota_handle_t *handle, const void *data, int size)
+{
+    if (!handle || !handle->buffer || !data || size < 0) {
+        ESP_LOGE(TAG, "Invalid input parameters, handle:%p, data:%p, size:%d", handle, data, size);
+        return ESP_FAIL;
+    }
+
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t len = size;
+
+    while (len > 0) {
+        uint32_t used = 0;
+        esp_err_t ret = ESP_OK;
+
+        switch (handle->state) {
+        case AT_DELTA_OTA_STATE_HEADER:
+            used = at_delta_ota_stage(handle, &handle->header, sizeof(at_delta_ota_header_t), p, len);
+            if (handle->stage_len == sizeof(at_delta_ota_header_t)) {
+                handle->stage_len = 0;
+                ret = at_delta_ota_header_check(handle);
+                handle->state = AT_DELTA_OTA_STATE_OP;
+            }
+            break;
+
+        case AT_DELTA_OTA_STATE_OP:
+            used = at_delta_ota_stage(handle, handle->stage, sizeof(at_delta_ota_op_t), p, len);
+            if (handle->stage_len == sizeof(at_delta_ota_op_t)) {
+                handle->stage_len = 0;
+                ret = at_delta_ota_op_start(handle);
+            }
+            break;
+
+        case AT_DELTA_OTA_STATE_INSERT:
+            used = MIN(len, handle->op_remain);
+            ret = at_delta_ota_output(handle, p, used);
+            handle->op_remain -= used;
+            if (handle->op_remain == 0) {
+                handle->state = AT_DELTA_OTA_STATE_OP;
+            }
+            break;
+
+        case AT_DELTA_OTA_STATE_DIFF_RECORD:
+            used = at_delta_ota_stage(handle, handle->stage, sizeof(uint16_t) * 2, p, len);
+            if (handle->stage_len == sizeof(uint16_t) * 2) {
+                handle->stage_len = 0;
+                ret = at_delta_ota_diff_record_start(handle);
+            }
+            break;
+
+        case AT_DELTA_OTA_STATE_DIFF_DATA:
+            used = MIN(len, handle->diff_remain);
+            ret = at_delta_ota_output(handle, p, used);
+            // the new data replaces the same length of the running firmware
+            handle->src_offset += used;
+            handle->op_remain -= used;
+            handle->diff_remain -= used;
+            if (handle->diff_remain == 0) {
+                handle->state = AT_DELTA_OTA_STATE_DIFF_RECORD;
+            }
+            break;
+
+        default:
+            ESP_LOGE(TAG, "Delta image overlength, %d bytes left", len);
+            return ESP_FAIL;
+        }
+
+        if (ret != ESP_OK) {
+            return ESP_FAIL;
+        }
+        if (handle->state != AT_DELTA_OTA_STATE_HEADER) {
+            at_delta_ota_op_end_check(handle);
+        }
+        p += used;
+        len -= used;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t at_delta_ota_end(at_delta_ota_handle_t *handle)
+{
+    if (!handle) {
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = ESP_FAIL;
+    uint8_t digest[16] = {0};
+
+    if (handle->state != AT_DELTA_OTA_STATE_DONE) {
+        ESP_LOGE(TAG, "Incomplete delta image (expected:%d, saw:%d)", handle->header.dst_size, handle->wrote_size);
+        goto exit;
+    }
+    if (at_delta_ota_flush(handle) != ESP_OK) {
+        goto exit;
+    }
+
+    esp_rom_md5_final(digest, &handle->md5_context);
+    if (memcmp(digest, handle->header.dst_md5, sizeof(digest))) {
+        ESP_LOGE(TAG, "New firmware MD5 check failed");
+        goto exit;
+    }
+
+    // esp_ota_end() validates the new firmware
+    ret = esp_ota_end(handle->ota_handle);
+    handle->ota_handle = 0;
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_end failed: %s", esp_err_to_name(ret));
+        goto exit;
+    }
+    ret = esp_ota_set_boot_partition(handle->dst_partition);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_set_boot_partition failed: %s", esp_err_to_name(ret));
+        goto exit;
+    }
+    ESP_LOGI(TAG, "Delta image applied, %d bytes rebuilt", handle->wrote_size);
+
+exit:
+    if (handle->ota_handle) {
+        esp_ota_abort(handle->ota_handle);
+        handle->ota_handle = 0;
+    }
+    free(handle->buffer);
+    handle->buffer = NULL;
+
+    return ret;
+}
+
+esp_err_t at_delta_https_ota(const esp_http_client_config_t *config)
+{
+    if (!config) {
+        return ESP_FAIL;
+    }
+
+    esp_http_client_handle_t client = esp_http_client_init(config);
+    if (client == NULL) {
+        ESP_LOGE(TAG, "Failed to initialise HTTP connection");
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = esp_http_client_open(client, 0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open HTTP connection: %s", esp_err_to_name(ret));
+        esp_http_client_cleanup(client);
+        return ESP_FAIL;
+    }
+
+    esp_http_client_fetch_headers(client);
+    int status_code = esp_http_client_get_status_code(client);
+    if (status_code >= HttpStatus_BadRequest) {
+        ESP_LOGE(TAG, "HTTP client error (%d)", status_code);
+        esp_http_client_cleanup(client);
+        return ESP_FAIL;
+    }
+
+    at_delta_ota_handle_t *handle = (at_delta_ota_handle_t *)calloc(1, sizeof(at_delta_ota_handle_t));
+    uint8_t *data = (uint8_t *)malloc(AT_DELTA_OTA_BUFFER_SIZE);
+    if (!handle || !data || at_delta_ota_begin(handle) != ESP_OK) {
+        free(data);
+        if (handle) {
+            free(handle->buffer);
+            free(handle);
+        }
+        esp_http_client_cleanup(client);
+        return ESP_FAIL;
+    }
+
+    int data_len = 0;
+    do {
+        data_len = esp_http_client_read(client, (char *)data, AT_DELTA_OTA_BUFFER_SIZE);
+        if (data_len > 0) {
+            ret = at_delta_ota_write(handle, data, data_len);
+        } else if (data_len < 0) {
+            ESP_LOGE(TAG, "Connection aborted");
+            ret = ESP_FAIL;
+        }
+    } while (ret == ESP_OK && data_len > 0);
+
+    esp_http_client_cleanup(client);
+    free(data);
+
+    // release the handle whether the download succeeds or not
+    esp_err_t end_ret = at_delta_ota_end(handle);
+    free(handle);
+
+    return (ret == ESP_OK ? end_ret : ret);
+}
+
+#endif
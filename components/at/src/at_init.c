@@ -20,6 +20,14 @@
 #include "esp_task_wdt.h"
 #endif
 
+#ifdef CONFIG_AT_LOG_DEFERRED
+#include "at_log_deferred.h"
+#endif
+#ifdef CONFIG_AT_NVS_WRITE_BACK_CACHE
+#include "at_nvs_cache.h"
+#endif
+#include "at_boot_prof.h"
+
 #if defined(CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE) && !defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED)
 #include "esp_ota_ops.h"
 #endif
@@ -355,9 +363,21 @@ static void at_ota_mark_app_valid_cancel_rollback(void)
 
 void esp_at_init(void)
 {
+    AT_BOOT_PROF_MARK("before esp_at_init");
+
     // set log level to max
     esp_log_level_set("*", ESP_LOG_MAX);
 
+#ifdef CONFIG_AT_LOG_DEFERRED
+    // output the AT logs from a low-priority task from now on
+    at_log_deferred_init();
+#endif
+
+#ifdef CONFIG_AT_NVS_WRITE_BACK_CACHE
+    // cache the AT configurations written to nvs from now on
+    at_nvs_cache_init();
+#endif
+
     // register the callback function to be invoked if a memory allocation operation fails
     heap_caps_register_failed_alloc_callback(at_alloc_failed_cb);
 
@@ -365,9 +385,11 @@ void esp_at_init(void)
     // reconfigure task watchdog timer to cancel the panic trigger when AT_DEBUG is enabled
     at_reconfigure_twdt();
 #endif
+    AT_BOOT_PROF_MARK("esp_at_init setup");
 
     // initialize the manufacturing nvs partition
     at_nvs_flash_init_partition();
+    AT_BOOT_PROF_MARK("at_nvs_flash_init_partition");
 
 #ifdef CONFIG_AT_WIFI_COMMAND_SUPPORT
     // initialize the interface for wifi station and softap
@@ -378,46 +400,58 @@ void esp_at_init(void)
 #ifdef CONFIG_AT_WIFI_DUMP_STATIS_DEBUG
     xTaskCreate(at_wifi_statistics_task, "wifi-dbg", 2048, NULL, 1, NULL);
 #endif
+    AT_BOOT_PROF_MARK("at_wifi_init");
 #endif
 
     // initialize the interface for esp-at and mcu communication
     at_interface_init();
+    AT_BOOT_PROF_MARK("at_interface_init");
 
     // initialize the module configuration based on the parameters in the manufacturing partition
     at_module_config_init();
+    AT_BOOT_PROF_MARK("at_module_config_init");
 
 #ifdef CONFIG_AT_WIFI_COMMAND_SUPPORT
     // initialize the wifi configuration based on the parameters in the manufacturing partition
     at_wifi_config_init();
+    AT_BOOT_PROF_MARK("at_wifi_config_init");
 #endif
 
     // initialize the AT framework (init task, queue, at cmd parser, at cmd responder, etc)
     at_module_init();
+    AT_BOOT_PROF_MARK("at_module_init");
 
-    // register all the at command set
+    // register all the at command set, each command set is marked by itself
     esp_at_cmd_set_register();
 
 #ifdef CONFIG_BT_ENABLED
     // release possible memory allocated by the bt controller
     at_bt_controller_mem_release();
+    AT_BOOT_PROF_MARK("at_bt_controller_mem_release");
 #endif
 
 #ifdef CONFIG_AT_COMMAND_TERMINATOR_SUPPORT
     // set the AT command terminator
     at_cmd_set_terminator(CONFIG_AT_COMMAND_TERMINATOR);
+    AT_BOOT_PROF_MARK("at_cmd_set_terminator");
 #endif
 
     // do some special things before AT is ready
     esp_at_ready_before();
+    AT_BOOT_PROF_MARK("esp_at_ready_before");
 
 #if defined(CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE) && !defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED)
     // indicate that the running app is working well for app rollback
     at_ota_mark_app_valid_cancel_rollback();
+    AT_BOOT_PROF_MARK("at_ota_mark_app_valid_cancel_rollback");
 #endif
 
     // once the interface is started, the AT command can be received and processed
     at_interface_start();
+    AT_BOOT_PROF_MARK("at_interface_start");
 
     esp_at_ready();
+    AT_BOOT_PROF_MARK("esp_at_ready");
+    AT_BOOT_PROF_REPORT();
     ESP_LOGD(TAG, "esp_at_init done");
 }
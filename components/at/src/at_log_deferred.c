@@ -0,0 +1,406 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#ifdef CONFIG_AT_LOG_DEFERRED
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include "esp_log.h"
+#include "at_log_deferred.h"
+
+#define AT_LOG_RECORD_MAX_LEN               128     // the max length of one record, the longer strings are truncated
+#define AT_LOG_SPEC_MAX_LEN                 24      // the max length of one conversion specification, e.g., "%-08.*lld"
+#define AT_LOG_LINE_MAX_LEN                 256     // the max length of one formatted log line
+#define AT_LOG_TASK_STACK_SIZE              3072
+#define AT_LOG_TASK_PRIORITY                1
+
+typedef enum {
+    AT_LOG_ARG_NONE,                        // "%%", no argument
+    AT_LOG_ARG_INT,                         // the integers no longer than int, and char
+    AT_LOG_ARG_INT64,                       // long long and intmax_t
+    AT_LOG_ARG_DOUBLE,
+    AT_LOG_ARG_PTR,
+    AT_LOG_ARG_STR,
+    AT_LOG_ARG_INVALID,                     // unsupported conversion, e.g., "%n", the rest of the format is ignored
+} at_log_arg_type_t;
+
+typedef struct {
+    uint32_t timestamp;                     // the timestamp when the log is written
+    const char *tag;
+    const char *format;
+    uint8_t level;
+    uint8_t truncated;                      // 1: the rest of the arguments are not recorded since the record is full
+    uint16_t args_len;                      // the length of the raw arguments following the record header
+} at_log_record_t;
+
+// static variables
+static RingbufHandle_t s_log_ringbuf;
+static uint32_t s_log_dropped;
+static portMUX_TYPE s_log_lock = portMUX_INITIALIZER_UNLOCKED;
+static const char *TAG = "at-log";
+
+/**
+ * @brief Parse the conversion specification following '%'.
+ *
+ * @param[in] spec: The conversion specification without '%'
+ * @param[out] type: The type of the argument
+ * @param[out] stars: The number of '*' in the field width and the precision, each takes an int argument
+ * @param[out] precision: The precision given in digits, -1 if it is not given, -2 if it is given by '*'
+ *
+ * @return the pointer to the character following the conversion specification
+ */
+static const char *at_log_spec_parse(const char *spec, at_log_arg_type_t *type, uint8_t *stars, int *precision)
+{
+    const char *p = spec;
+    uint8_t long_num = 0;
+    bool wide = false;
+
+    *stars = 0;
+    *precision = -1;
+    while (*p && strchr("-+ #0", *p)) {
+        p++;
+    }
+    if (*p == '*') {
+        (*stars)++;
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            (*stars)++;
+            *precision = -2;
+            p++;
+        } else {
+            *precision = 0;
+            while (*p >= '0' && *p <= '9') {
+                *precision = *precision * 10 + (*p++ - '0');
+            }
+        }
+    }
+    while (*p && strchr("hlLjzt", *p)) {
+        if (*p == 'l') {
+            long_num++;
+        } else if (*p == 'j' || *p == 'L') {
+            long_num = 2;
+        } else if (*p == 'z' || *p == 't') {
+            wide = (sizeof(size_t) > sizeof(int));
+        }
+        p++;
+    }
+    if (long_num == 1) {
+        wide = (sizeof(long) > sizeof(int));
+    } else if (long_num >= 2) {
+        wide = true;
+    }
+
+    switch (*p) {
+    case '%':
+        *type = AT_LOG_ARG_NONE;
+        break;
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+        *type = wide ? AT_LOG_ARG_INT64 : AT_LOG_ARG_INT;
+        break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        *type = AT_LOG_ARG_DOUBLE;
+        break;
+    case 'p':
+        *type = AT_LOG_ARG_PTR;
+        break;
+    case 's':
+        *type = AT_LOG_ARG_STR;
+        break;
+    default:
+        *type = AT_LOG_ARG_INVALID;
+        return p;
+    }
+
+    return p + 1;
+}
+
+static bool at_log_arg_put(uint8_t *args, uint16_t *args_len, uint16_t args_size, const void *value, uint16_t len)
+{
+    if (*args_len + len > args_size) {
+        return false;
+    }
+    memcpy(args + *args_len, value, len);
+    *args_len += len;
+    return true;
+}
+
+static bool at_log_arg_get(const uint8_t *args, uint16_t *offset, uint16_t args_len, void *value, uint16_t len)
+{
+    if (*offset + len > args_len) {
+        return false;
+    }
+    memcpy(value, args + *offset, len);
+    *offset += len;
+    return true;
+}
+
+static void at_log_record_encode(at_log_record_t *record, uint16_t args_size, const char *format, va_list args)
+{
+    uint8_t *record_args = (uint8_t *)(record + 1);
+    const char *p = format;
+    at_log_arg_type_t type;
+    uint8_t stars = 0;
+    int precision = -1;
+    bool ok = true;
+
+    while (ok && (p = strchr(p, '%')) != NULL) {
+        p = at_log_spec_parse(p + 1, &type, &stars, &precision);
+        if (type == AT_LOG_ARG_NONE) {
+            continue;
+        } else if (type == AT_LOG_ARG_INVALID) {
+            break;
+        }
+
+        for (uint8_t i = 0; ok && i < stars; i++) {
+            int value = va_arg(args, int);
+            if (i == stars - 1 && precision == -2) {
+                precision = value;
+            }
+            ok = at_log_arg_put(record_args, &record->args_len, args_size, &value, sizeof(value));
+        }
+        if (!ok) {
+            break;
+        }
+
+        switch (type) {
+        case AT_LOG_ARG_INT: {
+            unsigned int value = va_arg(args, unsigned int);
+            ok = at_log_arg_put(record_args, &record->args_len, args_size, &value, sizeof(value));
+            break;
+        }
+        case AT_LOG_ARG_INT64: {
+            unsigned long long value = va_arg(args, unsigned long long);
+            ok = at_log_arg_put(record_args, &record->args_len, args_size, &value, sizeof(value));
+            break;
+        }
+        case AT_LOG_ARG_DOUBLE: {
+            double value = va_arg(args, double);
+            ok = at_log_arg_put(record_args, &record->args_len, args_size, &value, sizeof(value));
+            break;
+        }
+        case AT_LOG_ARG_PTR: {
+            void *value = va_arg(args, void *);
+            ok = at_log_arg_put(record_args, &record->args_len, args_size, &value, sizeof(value));
+            break;
+        }
+        case AT_LOG_ARG_STR: {
+            // the string may not outlive the call, copy it with its terminator, it is truncated if the record is full
+            const char *value = va_arg(args, const char *);
+            if (value == NULL) {
+                value = "(null)";
+            }
+            if (record->args_len + 1 > args_size) {
+                ok = false;
+                break;
+            }
+            size_t max_len = args_size - record->args_len - 1;
+            if (precision >= 0 && (size_t)precision < max_len) {
+                max_len = precision;
+            }
+            uint16_t len = strnlen(value, max_len);
+            memcpy(record_args + record->args_len, value, len);
+            record_args[record->args_len + len] = '\0';
+            record->args_len += len + 1;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    record->truncated = ok ? 0 : 1;
+}
+
+static int at_log_line_append(int pos, int size, int len)
+{
+    if (len < 0) {
+        return pos;
+    }
+    return (pos + len >= size) ? (size - 1) : (pos + len);
+}
+
+static void at_log_record_format(const at_log_record_t *record, char *line, int size)
+{
+    static const char level_str[ESP_LOG_MAX] = {'N', 'E', 'W', 'I', 'D', 'V'};
+    const uint8_t *args = (const uint8_t *)(record + 1);
+    const char *p = record->format;
+    char spec[AT_LOG_SPEC_MAX_LEN];
+    uint16_t offset = 0;
+    at_log_arg_type_t type;
+    uint8_t stars = 0;
+    int precision = -1;
+    int pos = 0;
+    bool ok = true;
+
+    pos = at_log_line_append(pos, size, snprintf(line, size, "%c (%u) %s: ", level_str[record->level], record->timestamp, record->tag));
+    while (*p && pos < size - 1) {
+        if (*p != '%') {
+            line[pos++] = *p++;
+            continue;
+        }
+
+        const char *spec_end = at_log_spec_parse(p + 1, &type, &stars, &precision);
+        if (type == AT_LOG_ARG_INVALID) {
+            break;
+        } else if (type == AT_LOG_ARG_NONE) {
+            line[pos++] = '%';
+            p = spec_end;
+            continue;
+        }
+
+        // rebuild the specification with the recorded '*' values, e.g., "%.*s" -> "%.8s"
+        int spec_len = 0;
+        for (const char *s = p; s < spec_end && ok; s++) {
+            if (*s == '*') {
+                int value = 0;
+                ok = at_log_arg_get(args, &offset, record->args_len, &value, sizeof(value));
+                spec_len += snprintf(spec + spec_len, sizeof(spec) - spec_len, "%d", value);
+            } else {
+                spec[spec_len++] = *s;
+            }
+            ok = ok && (spec_len < sizeof(spec) - 1);
+        }
+        if (!ok) {
+            break;
+        }
+        spec[spec_len] = '\0';
+        p = spec_end;
+
+        int len = 0;
+        switch (type) {
+        case AT_LOG_ARG_INT: {
+            unsigned int value = 0;
+            ok = at_log_arg_get(args, &offset, record->args_len, &value, sizeof(value));
+            len = ok ? snprintf(line + pos, size - pos, spec, value) : 0;
+            break;
+        }
+        case AT_LOG_ARG_INT64: {
+            unsigned long long value = 0;
+            ok = at_log_arg_get(args, &offset, record->args_len, &value, sizeof(value));
+            len = ok ? snprintf(line + pos, size - pos, spec, value) : 0;
+            break;
+        }
+        case AT_LOG_ARG_DOUBLE: {
+            double value = 0;
+            ok = at_log_arg_get(args, &offset, record->args_len, &value, sizeof(value));
+            len = ok ? snprintf(line + pos, size - pos, spec, value) : 0;
+            break;
+        }
+        case AT_LOG_ARG_PTR: {
+            void *value = NULL;
+            ok = at_log_arg_get(args, &offset, record->args_len, &value, sizeof(value));
+            len = ok ? snprintf(line + pos, size - pos, spec, value) : 0;
+            break;
+        }
+        case AT_LOG_ARG_STR: {
+            const char *value = (const char *)args + offset;
+            ok = (offset < record->args_len);
+            if (ok) {
+                offset += strlen(value) + 1;
+                len = snprintf(line + pos, size - pos, spec, value);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        if (!ok) {
+            break;
+        }
+        pos = at_log_line_append(pos, size, len);
+    }
+
+    if (!ok || record->truncated) {
+        pos = at_log_line_append(pos, size, snprintf(line + pos, size - pos, "..."));
+    }
+    if (pos >= size - 1) {
+        pos = size - 2;
+    }
+    line[pos++] = '\n';
+    line[pos] = '\0';
+}
+
+static void at_log_deferred_task(void *params)
+{
+    static char line[AT_LOG_LINE_MAX_LEN];
+    size_t size = 0;
+
+    for (;;) {
+        at_log_record_t *record = (at_log_record_t *)xRingbufferReceive(s_log_ringbuf, &size, portMAX_DELAY);
+        if (record == NULL) {
+            continue;
+        }
+        esp_log_level_t level = record->level;
+        const char *tag = record->tag;
+        at_log_record_format(record, line, sizeof(line));
+        vRingbufferReturnItem(s_log_ringbuf, record);
+        esp_log_write(level, tag, "%s", line);
+
+        portENTER_CRITICAL(&s_log_lock);
+        uint32_t dropped = s_log_dropped;
+        s_log_dropped = 0;
+        portEXIT_CRITICAL(&s_log_lock);
+        if (dropped) {
+            esp_log_write(ESP_LOG_WARN, TAG, "W (%u) %s: %u logs dropped\n", esp_log_timestamp(), TAG, dropped);
+        }
+    }
+}
+
+void at_log_deferred_init(void)
+{
+    if (s_log_ringbuf) {
+        return;
+    }
+
+    RingbufHandle_t ringbuf = xRingbufferCreate(CONFIG_AT_LOG_DEFERRED_BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+    if (ringbuf == NULL) {
+        ESP_LOGE(TAG, "ringbuf create failed");
+        return;
+    }
+    s_log_ringbuf = ringbuf;
+
+    if (xTaskCreate(at_log_deferred_task, "at_log", AT_LOG_TASK_STACK_SIZE, NULL, AT_LOG_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "task create failed");
+        s_log_ringbuf = NULL;
+        vRingbufferDelete(ringbuf);
+    }
+}
+
+bool at_log_deferred_writev(esp_log_level_t level, const char *tag, const char *format, va_list args)
+{
+    uint32_t buf[AT_LOG_RECORD_MAX_LEN / sizeof(uint32_t)];
+    at_log_record_t *record = (at_log_record_t *)buf;
+
+    if (s_log_ringbuf == NULL || xPortInIsrContext()) {
+        return false;
+    }
+
+    record->timestamp = esp_log_timestamp();
+    record->tag = tag;
+    record->format = format;
+    record->level = level;
+    record->args_len = 0;
+    at_log_record_encode(record, sizeof(buf) - sizeof(at_log_record_t), format, args);
+
+    if (xRingbufferSend(s_log_ringbuf, record, sizeof(at_log_record_t) + record->args_len, 0) != pdTRUE) {
+        portENTER_CRITICAL(&s_log_lock);
+        s_log_dropped++;
+        portEXIT_CRITICAL(&s_log_lock);
+    }
+
+    return true;
+}
+#endif
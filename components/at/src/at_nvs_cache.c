@@ -0,0 +1,400 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/queue.h>
+#include "sdkconfig.h"
+
+#ifdef CONFIG_AT_NVS_WRITE_BACK_CACHE
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "nvs_flash.h"
+#include "esp_at.h"
+#include "at_nvs_cache.h"
+
+#define AT_NVS_CACHE_HANDLE_MAX             16      // the max number of the tracked handles which are open at the same time
+#define AT_NVS_CACHE_TASK_STACK_SIZE        3072
+#define AT_NVS_CACHE_TASK_PRIORITY          1
+
+typedef struct {
+    nvs_handle_t handle;                    // 0: the slot is free
+    bool writable;
+    char namespace_name[NVS_KEY_NAME_MAX_SIZE];
+} at_nvs_cache_handle_t;
+
+typedef struct at_nvs_cache_entry {
+    char namespace_name[NVS_KEY_NAME_MAX_SIZE];
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    nvs_type_t type;
+    size_t length;
+    uint8_t *value;
+    SLIST_ENTRY(at_nvs_cache_entry) next;
+} at_nvs_cache_entry_t;
+
+// the real nvs apis, see the -Wl,--wrap options in CMakeLists.txt
+esp_err_t __real_nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle);
+void __real_nvs_close(nvs_handle_t handle);
+esp_err_t __real_nvs_erase_key(nvs_handle_t handle, const char *key);
+esp_err_t __real_nvs_erase_all(nvs_handle_t handle);
+esp_err_t __real_nvs_flash_erase(void);
+esp_err_t __real_nvs_flash_erase_partition(const char *part_name);
+
+// static variables
+static at_nvs_cache_handle_t s_handles[AT_NVS_CACHE_HANDLE_MAX];
+static portMUX_TYPE s_handles_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_handles_full_warned;
+static SemaphoreHandle_t s_cache_mutex;
+static StaticSemaphore_t s_cache_mutex_buffer;
+static SLIST_HEAD(at_nvs_cache_list_head_, at_nvs_cache_entry) s_cache_list = SLIST_HEAD_INITIALIZER(s_cache_list);
+static size_t s_cache_size;
+static TaskHandle_t s_cache_task;
+static const char *TAG = "at-nvs-cache";
+
+static bool at_nvs_cache_handle_lookup(nvs_handle_t handle, char *namespace_name, bool *writable)
+{
+    bool found = false;
+
+    taskENTER_CRITICAL(&s_handles_lock);
+    for (int i = 0; i < AT_NVS_CACHE_HANDLE_MAX; i++) {
+        if (handle && s_handles[i].handle == handle) {
+            strcpy(namespace_name, s_handles[i].namespace_name);
+            *writable = s_handles[i].writable;
+            found = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_handles_lock);
+
+    return found;
+}
+
+static at_nvs_cache_entry_t *at_nvs_cache_entry_find(const char *namespace_name, const char *key)
+{
+    at_nvs_cache_entry_t *entry;
+    SLIST_FOREACH(entry, &s_cache_list, next) {
+        if (strcmp(entry->key, key) == 0 && strcmp(entry->namespace_name, namespace_name) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void at_nvs_cache_entry_free(at_nvs_cache_entry_t *entry)
+{
+    SLIST_REMOVE(&s_cache_list, entry, at_nvs_cache_entry, next);
+    s_cache_size -= entry->length;
+    free(entry->value);
+    free(entry);
+}
+
+/**
+ * @brief Drop the cached values without writing them back.
+ *
+ * @param[in] namespace_name: The namespace of the values, NULL for all namespaces
+ * @param[in] key: The key of the value, NULL for all keys in the namespace
+ *
+ * @return true if any value is dropped
+ */
+static bool at_nvs_cache_drop(const char *namespace_name, const char *key)
+{
+    bool dropped = false;
+    at_nvs_cache_entry_t *entry, *tmp;
+
+    if (!s_cache_mutex) {
+        return false;
+    }
+
+    xSemaphoreTake(s_cache_mutex, portMAX_DELAY);
+    for (entry = SLIST_FIRST(&s_cache_list); entry != NULL; entry = tmp) {
+        tmp = SLIST_NEXT(entry, next);
+        if ((!namespace_name || strcmp(entry->namespace_name, namespace_name) == 0) && (!key || strcmp(entry->key, key) == 0)) {
+            at_nvs_cache_entry_free(entry);
+            dropped = true;
+        }
+    }
+    xSemaphoreGive(s_cache_mutex);
+
+    return dropped;
+}
+
+static esp_err_t at_nvs_cache_flush_locked(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    while (!SLIST_EMPTY(&s_cache_list)) {
+        // write back the values of one namespace with a single commit
+        char namespace_name[NVS_KEY_NAME_MAX_SIZE];
+        strcpy(namespace_name, SLIST_FIRST(&s_cache_list)->namespace_name);
+
+        nvs_handle_t handle;
+        esp_err_t err = __real_nvs_open(namespace_name, NVS_READWRITE, &handle);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "open %s failed:0x%x", namespace_name, err);
+            ret = err;
+        }
+
+        at_nvs_cache_entry_t *entry, *tmp;
+        for (entry = SLIST_FIRST(&s_cache_list); entry != NULL; entry = tmp) {
+            tmp = SLIST_NEXT(entry, next);
+            if (strcmp(entry->namespace_name, namespace_name) != 0) {
+                continue;
+            }
+            if (err == ESP_OK) {
+                esp_err_t set_ret = (entry->type == NVS_TYPE_STR) ? nvs_set_str(handle, entry->key, (const char *)entry->value)
+                                    : nvs_set_blob(handle, entry->key, entry->value, entry->length);
+                if (set_ret != ESP_OK) {
+                    ESP_LOGE(TAG, "set %s:%s failed:0x%x", namespace_name, entry->key, set_ret);
+                    ret = set_ret;
+                }
+            }
+            // the failed value is dropped as well, otherwise it would be retried forever
+            at_nvs_cache_entry_free(entry);
+        }
+
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "commit %s failed:0x%x", namespace_name, err);
+                ret = err;
+            }
+            __real_nvs_close(handle);
+        }
+    }
+
+    return ret;
+}
+
+static void at_nvs_cache_task(void *params)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // every new write restarts the idle wait, so that a burst of writes is committed once
+        while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_AT_NVS_CACHE_FLUSH_DELAY)) > 0) {
+        }
+
+        esp_at_nvs_flush();
+    }
+}
+
+static void at_nvs_cache_shutdown_handler(void)
+{
+    // esp_restart() from the paths which do not go through the pre-restart callback, e.g., a user command
+    esp_at_nvs_flush();
+}
+
+void at_nvs_cache_init(void)
+{
+    if (s_cache_mutex) {
+        return;
+    }
+
+    s_cache_mutex = xSemaphoreCreateMutexStatic(&s_cache_mutex_buffer);
+    if (xTaskCreate(at_nvs_cache_task, "at_nvs_cache", AT_NVS_CACHE_TASK_STACK_SIZE, NULL, AT_NVS_CACHE_TASK_PRIORITY, &s_cache_task) != pdPASS) {
+        ESP_LOGE(TAG, "task create failed");
+        vSemaphoreDelete(s_cache_mutex);
+        s_cache_mutex = NULL;
+        return;
+    }
+    esp_register_shutdown_handler(at_nvs_cache_shutdown_handler);
+}
+
+esp_err_t at_nvs_cache_set(nvs_handle_t handle, const char *key, nvs_type_t type, const void *value, size_t length)
+{
+    char namespace_name[NVS_KEY_NAME_MAX_SIZE];
+    bool writable = false;
+
+    if (!s_cache_mutex || !key || strlen(key) >= NVS_KEY_NAME_MAX_SIZE
+            || !at_nvs_cache_handle_lookup(handle, namespace_name, &writable) || !writable) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    uint8_t *data = NULL;
+    if (length <= CONFIG_AT_NVS_CACHE_SIZE) {
+        data = malloc(length ? length : 1);
+    }
+    if (!data) {
+        // the value goes to NVS directly, so that the stale cached value must not be written back later
+        at_nvs_cache_drop(namespace_name, key);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (length) {
+        memcpy(data, value, length);
+    }
+
+    xSemaphoreTake(s_cache_mutex, portMAX_DELAY);
+    at_nvs_cache_entry_t *entry = at_nvs_cache_entry_find(namespace_name, key);
+    if (s_cache_size - (entry ? entry->length : 0) + length > CONFIG_AT_NVS_CACHE_SIZE) {
+        // the cache is full, write back all the values first
+        at_nvs_cache_flush_locked();
+        entry = NULL;
+    }
+    if (!entry) {
+        entry = calloc(1, sizeof(at_nvs_cache_entry_t));
+        if (!entry) {
+            xSemaphoreGive(s_cache_mutex);
+            free(data);
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        strcpy(entry->namespace_name, namespace_name);
+        strcpy(entry->key, key);
+        SLIST_INSERT_HEAD(&s_cache_list, entry, next);
+    }
+    s_cache_size = s_cache_size - entry->length + length;
+    free(entry->value);
+    entry->type = type;
+    entry->length = length;
+    entry->value = data;
+    xSemaphoreGive(s_cache_mutex);
+
+    xTaskNotifyGive(s_cache_task);
+
+    return ESP_OK;
+}
+
+esp_err_t at_nvs_cache_get(nvs_handle_t handle, const char *key, nvs_type_t type, void *out_value, size_t *length)
+{
+    char namespace_name[NVS_KEY_NAME_MAX_SIZE];
+    bool writable = false;
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    if (!s_cache_mutex || !key || !at_nvs_cache_handle_lookup(handle, namespace_name, &writable)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    xSemaphoreTake(s_cache_mutex, portMAX_DELAY);
+    at_nvs_cache_entry_t *entry = at_nvs_cache_entry_find(namespace_name, key);
+    if (entry) {
+        if (entry->type != type) {
+            ret = ESP_ERR_NVS_TYPE_MISMATCH;
+        } else if (!length) {
+            ret = ESP_ERR_NVS_INVALID_LENGTH;
+        } else if (!out_value) {
+            *length = entry->length;
+            ret = ESP_OK;
+        } else if (*length < entry->length) {
+            *length = entry->length;
+            ret = ESP_ERR_NVS_INVALID_LENGTH;
+        } else {
+            memcpy(out_value, entry->value, entry->length);
+            *length = entry->length;
+            ret = ESP_OK;
+        }
+    }
+    xSemaphoreGive(s_cache_mutex);
+
+    return ret;
+}
+
+esp_err_t esp_at_nvs_flush(void)
+{
+    if (!s_cache_mutex) {
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(s_cache_mutex, portMAX_DELAY);
+    esp_err_t ret = at_nvs_cache_flush_locked();
+    xSemaphoreGive(s_cache_mutex);
+
+    return ret;
+}
+
+/**********************************************************************
+ *     The wrapped nvs apis which keep the cache consistent
+ *********************************************************************/
+esp_err_t __wrap_nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    esp_err_t ret = __real_nvs_open(namespace_name, open_mode, out_handle);
+    if (ret != ESP_OK || strlen(namespace_name) >= NVS_KEY_NAME_MAX_SIZE) {
+        return ret;
+    }
+
+    bool tracked = false;
+    taskENTER_CRITICAL(&s_handles_lock);
+    for (int i = 0; i < AT_NVS_CACHE_HANDLE_MAX; i++) {
+        if (s_handles[i].handle == 0) {
+            s_handles[i].handle = *out_handle;
+            s_handles[i].writable = (open_mode == NVS_READWRITE);
+            strcpy(s_handles[i].namespace_name, namespace_name);
+            tracked = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_handles_lock);
+
+    if (!tracked && !s_handles_full_warned) {
+        // the writes of this handle go to NVS directly
+        s_handles_full_warned = true;
+        ESP_LOGW(TAG, "too many open handles, please enlarge AT_NVS_CACHE_HANDLE_MAX");
+    }
+
+    return ret;
+}
+
+void __wrap_nvs_close(nvs_handle_t handle)
+{
+    taskENTER_CRITICAL(&s_handles_lock);
+    for (int i = 0; i < AT_NVS_CACHE_HANDLE_MAX; i++) {
+        if (s_handles[i].handle == handle) {
+            s_handles[i].handle = 0;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_handles_lock);
+
+    __real_nvs_close(handle);
+}
+
+esp_err_t __wrap_nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    char namespace_name[NVS_KEY_NAME_MAX_SIZE];
+    bool writable = false;
+    bool dropped = false;
+
+    if (key && at_nvs_cache_handle_lookup(handle, namespace_name, &writable) && writable) {
+        dropped = at_nvs_cache_drop(namespace_name, key);
+    }
+
+    esp_err_t ret = __real_nvs_erase_key(handle, key);
+    if (ret == ESP_ERR_NVS_NOT_FOUND && dropped) {
+        // the key was only in the cache
+        ret = ESP_OK;
+    }
+    return ret;
+}
+
+esp_err_t __wrap_nvs_erase_all(nvs_handle_t handle)
+{
+    char namespace_name[NVS_KEY_NAME_MAX_SIZE];
+    bool writable = false;
+
+    if (at_nvs_cache_handle_lookup(handle, namespace_name, &writable) && writable) {
+        at_nvs_cache_drop(namespace_name, NULL);
+    }
+
+    return __real_nvs_erase_all(handle);
+}
+
+esp_err_t __wrap_nvs_flash_erase(void)
+{
+    // e.g., AT+RESTORE, the cached values must not be written back after that
+    at_nvs_cache_drop(NULL, NULL);
+    return __real_nvs_flash_erase();
+}
+
+esp_err_t __wrap_nvs_flash_erase_partition(const char *part_name)
+{
+    if (part_name && strcmp(part_name, NVS_DEFAULT_PART_NAME) == 0) {
+        at_nvs_cache_drop(NULL, NULL);
+    }
+    return __real_nvs_flash_erase_partition(part_name);
+}
+#endif
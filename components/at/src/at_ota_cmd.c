@@ -25,6 +25,12 @@
 #include "at_ota.h"
 #include "esp_http_client.h"
 
+#include "at_ota_pipeline.h"
+#include "at_ota_http.h"
+#ifdef CONFIG_AT_OTA_RESUME_SUPPORT
+#include "at_ota_resume.h"
+#endif
+
 #if defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED) && defined(CONFIG_ENABLE_LEGACY_ESP_BOOTLOADER_PLUS_V2_SUPPORT)
 #include "at_compress_ota.h"
 #endif
@@ -61,6 +67,7 @@ Accept-Encoding: gzip,deflate,sdch\r\n\
 Accept-Language: zh-CN,zh;q=0.8\r\n\r\n"
 
 #define ESP_AT_OTA_TIMEOUT_MS               (60*3*1000)
+#define ESP_AT_OTA_PROGRESS_INTERVAL_MS     1000
 
 static TimerHandle_t esp_at_ota_timeout_timer = NULL;
 static bool esp_at_ota_timeout_flag = false;
@@ -103,6 +110,21 @@ static const at_partition_sig_t s_at_partition_sig[] = {
 #define NB_OTA_TASK_STACK_SIZE              5120  // for non-blocking ota
 #define AT_HTTP_CONTENT_LEN_MAX             8192
 #define AT_BUFFER_ON_STACK_SIZE              128
+#define AT_HTTP_STATUS_PARTIAL_CONTENT       206
+
+typedef struct {
+    at_upgrade_type_t upgrade_type;
+    uint32_t offset;                                /**< the offset to write in the partition */
+    const esp_partition_t *raw_partition;           /**< the partition written by esp_partition_write(), NULL: written by the ota handle */
+#ifdef CONFIG_AT_OTA_RESUME_SUPPORT
+    at_ota_resume_t *resume;                        /**< the download progress */
+#endif
+#if defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED) && defined(CONFIG_ENABLE_LEGACY_ESP_BOOTLOADER_PLUS_V2_SUPPORT)
+    at_compress_ota_handle_t *compress_handle;
+#else
+    esp_ota_handle_t ota_handle;
+#endif
+} at_ota_flash_writer_t;
 
 typedef struct {
     int32_t ota_mode;
@@ -167,9 +189,174 @@ static esp_err_t at_partition_verify(const char *name, uint8_t *data, int len)
     return ESP_FAIL;
 }
 
+static esp_err_t at_ota_flash_write(void *arg, const uint8_t *data, uint32_t len)
+{
+    at_ota_flash_writer_t *writer = (at_ota_flash_writer_t *)arg;
+    esp_err_t ret = ESP_FAIL;
+
+    if (writer->raw_partition) {
+        ret = esp_partition_write(writer->raw_partition, writer->offset, data, len);
+        if (ret != ESP_OK) {
+            ESP_AT_LOGE(TAG, "esp_partition_write failed");
+        }
+    } else if (writer->upgrade_type == AT_UPGRADE_SYSTEM_FIRMWARE) {
+#if defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED) && defined(CONFIG_ENABLE_LEGACY_ESP_BOOTLOADER_PLUS_V2_SUPPORT)
+        ret = at_compress_ota_write(writer->compress_handle, data, len);
+#else
+        ret = esp_ota_write(writer->ota_handle, (const void *)data, len);
+        if (ret != ESP_OK) {
+            ESP_AT_LOGE(TAG, "esp_ota_write failed");
+        }
+#endif
+    }
+
+    if (ret == ESP_OK) {
+        writer->offset += len;
+#ifdef CONFIG_AT_OTA_RESUME_SUPPORT
+        at_ota_resume_update(writer->resume, writer->offset);
+#endif
+    }
+    return ret;
+}
+
+static esp_err_t at_ota_partition_erase(const esp_partition_t *partition, uint32_t offset)
+{
+    esp_err_t ret = esp_partition_erase_range(partition, offset, partition->size - offset);
+    if (ret != ESP_OK) {
+        ESP_AT_LOGE(TAG, "esp_partition_erase_range failed");
+    }
+    return ret;
+}
+
+static esp_err_t at_ota_conn_open(at_ota_mode_t ota_mode, const struct sockaddr_in *sock_info, const char *server_ip, uint16_t server_port, void **tls)
+{
+    if (ota_mode == ESP_AT_OTA_MODE_NORMAL) {
+        int sockopt = 1;
+        esp_at_ota_socket_id = socket(AF_INET, SOCK_STREAM, 0);
+        if (esp_at_ota_socket_id < 0) {
+            return ESP_FAIL;
+        }
+        setsockopt(esp_at_ota_socket_id, SOL_SOCKET, SO_REUSEADDR, &sockopt, sizeof(sockopt));
+        if (connect(esp_at_ota_socket_id, (struct sockaddr *)sock_info, sizeof(struct sockaddr_in)) < 0) {
+            ESP_AT_LOGE(TAG, "connect to ota server failed");
+            return ESP_FAIL;
+        }
+        return ESP_OK;
+    }
+#ifdef CONFIG_AT_OTA_SSL_SUPPORT
+    else if (ota_mode == ESP_AT_OTA_MODE_SSL) {
+        esp_tls_t *conn = esp_tls_init();
+        esp_tls_cfg_t *tls_cfg = (esp_tls_cfg_t *)calloc(1, sizeof(esp_tls_cfg_t));
+        if (conn == NULL || tls_cfg == NULL) {
+            free(tls_cfg);
+            esp_tls_conn_destroy(conn);
+            return ESP_FAIL;
+        }
+
+        int ret = esp_tls_conn_new_sync(server_ip, strlen(server_ip), server_port, tls_cfg, conn);
+        free(tls_cfg);
+        if (ret < 0) {
+            ESP_AT_LOGE(TAG, "connect to ota server failed");
+            esp_tls_conn_destroy(conn);
+            return ESP_FAIL;
+        }
+        *tls = conn;
+        return ESP_OK;
+    }
+#endif
+
+    return ESP_FAIL;
+}
+
+static void at_ota_conn_close(void **tls)
+{
+#ifdef CONFIG_AT_OTA_SSL_SUPPORT
+    if (*tls) {
+        esp_tls_conn_destroy((esp_tls_t *)*tls);
+        *tls = NULL;
+    }
+#endif
+    if (esp_at_ota_socket_id >= 0) {
+        close(esp_at_ota_socket_id);
+        esp_at_ota_socket_id = -1;
+    }
+}
+
+static int at_ota_conn_write(at_ota_mode_t ota_mode, void *tls, const uint8_t *data, int len)
+{
+    if (ota_mode == ESP_AT_OTA_MODE_NORMAL) {
+        return write(esp_at_ota_socket_id, data, len);
+    }
+#ifdef CONFIG_AT_OTA_SSL_SUPPORT
+    else if (ota_mode == ESP_AT_OTA_MODE_SSL) {
+        return esp_tls_conn_write((esp_tls_t *)tls, data, len);
+    }
+#endif
+
+    return -1;
+}
+
+static int at_ota_conn_read(at_ota_mode_t ota_mode, void *tls, uint8_t *buffer, int len)
+{
+    if (ota_mode == ESP_AT_OTA_MODE_NORMAL) {
+        return read(esp_at_ota_socket_id, buffer, len);
+    }
+#ifdef CONFIG_AT_OTA_SSL_SUPPORT
+    else if (ota_mode == ESP_AT_OTA_MODE_SSL) {
+        return esp_tls_conn_read((esp_tls_t *)tls, buffer, len);
+    }
+#endif
+
+    return -1;
+}
+
+/**
+ * @brief Receive and parse the response header, the body data received with the header is left in the buffer.
+ */
+static esp_err_t at_ota_http_header_recv(at_ota_mode_t ota_mode, void *tls, at_ota_http_parser_t *parser,
+                                         uint8_t *buffer, int size, uint8_t **body, int *body_len)
+{
+    at_ota_http_parser_init(parser);
+    *body_len = 0;
+
+    while (!at_ota_http_header_done(parser)) {
+        int len = at_ota_conn_read(ota_mode, tls, buffer, size);
+        if (len <= 0) {
+            ESP_AT_LOGE(TAG, "recv http header failed");
+            return ESP_FAIL;
+        }
+
+        int header_len = at_ota_http_parse_header(parser, buffer, len);
+        if (header_len < 0) {
+            return ESP_FAIL;
+        }
+        *body = buffer + header_len;
+        *body_len = len - header_len;
+    }
+    ESP_AT_LOGI(TAG, "http status:%d content-length:%d chunked:%d keep-alive:%d",
+                parser->status_code, parser->content_len, parser->chunked, parser->keep_alive);
+
+    return ESP_OK;
+}
+
+#ifdef CONFIG_AT_OTA_PROGRESS_REPORT
+static void at_ota_progress_report(at_ota_pipeline_handle_t pipeline, uint32_t recv_len, uint32_t total_len)
+{
+    at_ota_pipeline_stats_t stats;
+    at_ota_pipeline_stats_get(pipeline, &stats);
+
+    // unit: KB/s
+    uint32_t download_rate = stats.download_ms ? (uint64_t)stats.download_bytes * 1000 / 1024 / stats.download_ms : 0;
+    uint32_t flash_rate = stats.flash_ms ? (uint64_t)stats.flash_bytes * 1000 / 1024 / stats.flash_ms : 0;
+
+    uint8_t buffer[AT_BUFFER_ON_STACK_SIZE] = {0};
+    snprintf((char *)buffer, AT_BUFFER_ON_STACK_SIZE, "+CIPUPDATEPROGRESS:%u,%u,%u,%u\r\n", recv_len, total_len, download_rate, flash_rate);
+    esp_at_port_write_data(buffer, strlen((char *)buffer));
+}
+#endif
+
 bool esp_at_upgrade_process(at_ota_mode_t ota_mode, uint8_t *version, const char *partition_name)
 {
-    bool pkg_body_start = false;
     struct sockaddr_in sock_info;
     ip_addr_t ip_address;
     struct hostent* hptr = NULL;
@@ -181,7 +368,6 @@ bool esp_at_upgrade_process(at_ota_mode_t ota_mode, uint8_t *version, const char
     const esp_partition_t* next_partition = NULL;
     esp_ota_handle_t out_handle = 0;
     int buff_len = 0;
-    int sockopt = 1;
     int total_len = 0;
     int recv_len = 0;
     bool ret = false;
@@ -192,13 +378,21 @@ bool esp_at_upgrade_process(at_ota_mode_t ota_mode, uint8_t *version, const char
     uint32_t module_id = esp_at_get_module_id();
     at_upgrade_type_t upgrade_type = 0;
     const esp_partition_t *at_custom_partition = NULL;
+    at_ota_pipeline_handle_t pipeline = NULL;
+    at_ota_flash_writer_t writer = {0};
+    const esp_partition_t *target_partition = NULL;
+    uint32_t resume_offset = 0;
+    int status_code = 0;
+    int body_len = 0;
+    int request_len = 0;
+    void *tls = NULL;
+    at_ota_http_parser_t parser;
+#ifdef CONFIG_AT_OTA_RESUME_SUPPORT
+    at_ota_resume_t resume;
+#endif
 #if defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED) && defined(CONFIG_ENABLE_LEGACY_ESP_BOOTLOADER_PLUS_V2_SUPPORT)
     at_compress_ota_handle_t handle;
 #endif
-#ifdef CONFIG_AT_OTA_SSL_SUPPORT
-    esp_tls_t *tls = NULL;
-    esp_tls_cfg_t *tls_cfg = NULL;
-#endif
 
     if (memcmp(partition_name, "ota", strlen("ota")) == 0) {
         upgrade_type = AT_UPGRADE_SYSTEM_FIRMWARE;
@@ -262,95 +456,64 @@ bool esp_at_upgrade_process(at_ota_mode_t ota_mode, uint8_t *version, const char
     }
 
     if (version == NULL) {
-        if (ota_mode == ESP_AT_OTA_MODE_NORMAL) {
-            esp_at_ota_socket_id = socket(AF_INET, SOCK_STREAM, 0);
-            if (esp_at_ota_socket_id < 0) {
-                goto OTA_ERROR;
-            }
-
-            setsockopt(esp_at_ota_socket_id, SOL_SOCKET, SO_REUSEADDR, &sockopt, sizeof(sockopt));
-            // connect to http server
-            if (connect(esp_at_ota_socket_id, (struct sockaddr *)&sock_info, sizeof(sock_info)) < 0) {
-                ESP_AT_LOGE(TAG, "connect to ota server failed");
-                goto OTA_ERROR;
-            }
-        }
-#ifdef CONFIG_AT_OTA_SSL_SUPPORT
-        else if (ota_mode == ESP_AT_OTA_MODE_SSL) {
-            tls = esp_tls_init();
-
-            tls_cfg = (esp_tls_cfg_t *)calloc(1, sizeof(esp_tls_cfg_t));
-            if (tls_cfg == NULL) {
-                goto OTA_ERROR;
-            }
-
-            if (esp_tls_conn_new_sync(server_ip, strlen(server_ip), server_port, tls_cfg, tls) < 0) {
-                ESP_AT_LOGE(TAG, "connect to ota server failed");
-                goto OTA_ERROR;
-            }
+        if (at_ota_conn_open(ota_mode, &sock_info, server_ip, server_port, &tls) != ESP_OK) {
+            goto OTA_ERROR;
         }
-#endif
         esp_at_set_upgrade_state(ESP_AT_OTA_STATE_CONNECTED_TO_SERVER);
         esp_at_port_write_data((uint8_t*)"+CIPUPDATE:2\r\n", strlen("+CIPUPDATE:2\r\n"));
 
-        snprintf((char*)http_request, TEXT_BUFFSIZE, "GET /v1/device/rom/?is_format_simple=true HTTP/1.0\r\nHost: %s:%d\r\n"pheadbuffer"",
+        snprintf((char*)http_request, TEXT_BUFFSIZE, "GET /v1/device/rom/?is_format_simple=true HTTP/1.1\r\nHost: %s:%d\r\n"pheadbuffer"",
                  server_ip, server_port, ota_key);
 
         /*send GET request to http server*/
-        result = -1;
-        if (ota_mode == ESP_AT_OTA_MODE_NORMAL) {
-            result = write(esp_at_ota_socket_id, http_request, strlen((char*)http_request));
-        }
-#ifdef CONFIG_AT_OTA_SSL_SUPPORT
-        else if (ota_mode == ESP_AT_OTA_MODE_SSL) {
-            result = esp_tls_conn_write(tls, (const unsigned char *)http_request, strlen((char *)http_request));
-        }
-#endif
-
+        result = at_ota_conn_write(ota_mode, tls, http_request, strlen((char*)http_request));
         if (result != strlen((char *)http_request)) {
             ESP_AT_LOGE(TAG, "send http request failed");
             goto OTA_ERROR;
         }
 
-        memset(data_buffer, 0x0, TEXT_BUFFSIZE + 1);
-
-        result = -1;
-        int offset = 0;
+        if (at_ota_http_header_recv(ota_mode, tls, &parser, data_buffer, TEXT_BUFFSIZE, &pStr, &body_len) != ESP_OK) {
+            goto OTA_ERROR;
+        }
+        if (parser.status_code != 200) {
+            ESP_AT_LOGE(TAG, "http status: %d", parser.status_code);
+            goto OTA_ERROR;
+        }
 
-        do {
-            if (ota_mode == ESP_AT_OTA_MODE_NORMAL) {
-                result = read(esp_at_ota_socket_id, data_buffer + offset, TEXT_BUFFSIZE - offset);
-            }
-#ifdef CONFIG_AT_OTA_SSL_SUPPORT
-            else if (ota_mode == ESP_AT_OTA_MODE_SSL) {
-                result = esp_tls_conn_read(tls, data_buffer + offset, TEXT_BUFFSIZE - offset);
+        // the version information is small, receive the whole body, so that the connection can be reused by the download
+        int version_len = at_ota_http_parse_body(&parser, pStr, body_len);
+        if (version_len < 0) {
+            goto OTA_ERROR;
+        }
+        memmove(data_buffer, pStr, version_len);
+        body_len = 0;
+        while (!at_ota_http_body_done(&parser)) {
+            int read_len = at_ota_http_body_read_len(&parser, TEXT_BUFFSIZE - version_len);
+            if (read_len == 0) {
+                ESP_AT_LOGE(TAG, "version information oversize");
+                goto OTA_ERROR;
             }
-#endif
-            if (result > 0) {
-                data_buffer[offset + result] = 0;
-                char *p1 = strstr((char *)data_buffer, "rom_version\": ");
-                char *p2 = strstr((char *)data_buffer, "status");
-                if (p1 && p2) {
-                    break;
-                } else {
-                    offset = result > 64 ? 64 : 0;
-                    memmove(data_buffer, data_buffer + result - offset, offset);
+            result = at_ota_conn_read(ota_mode, tls, data_buffer + version_len, read_len);
+            if (result < 0) {
+                ESP_AT_LOGE(TAG, "recv data failed");
+                goto OTA_ERROR;
+            } else if (result == 0) {
+                if (!at_ota_http_conn_closed(&parser)) {
+                    ESP_AT_LOGE(TAG, "incomplete version information");
+                    goto OTA_ERROR;
                 }
+                break;
             }
-        } while (result > 0);
-
-        if (result < 0) {
-            ESP_AT_LOGE(TAG, "recv data failed");
-            goto OTA_ERROR;
-        } else {
-#ifdef CONFIG_AT_OTA_SSL_SUPPORT
-            if (ota_mode == ESP_AT_OTA_MODE_SSL) {
-                esp_tls_conn_destroy(tls);
-                tls = NULL;
+            result = at_ota_http_parse_body(&parser, data_buffer + version_len, result);
+            if (result < 0) {
+                goto OTA_ERROR;
             }
-#endif
-            close(esp_at_ota_socket_id);
-            esp_at_ota_socket_id = -1;
+            version_len += result;
+        }
+        data_buffer[version_len] = '\0';
+
+        if (!parser.keep_alive) {
+            at_ota_conn_close(&tls);
         }
 
         pStr = (uint8_t*)strstr((char*)data_buffer, "rom_version\": ");
@@ -371,14 +534,12 @@ bool esp_at_upgrade_process(at_ota_mode_t ota_mode, uint8_t *version, const char
         esp_at_port_write_data((uint8_t*)"+CIPUPDATE:3\r\n", strlen("+CIPUPDATE:3\r\n"));
     }
     ESP_AT_LOGI(TAG, "version: %s\r\n", version);
-    snprintf((char*)http_request, TEXT_BUFFSIZE,
-             "GET /v1/device/rom/?action=download_rom&version=%s&filename=%s.bin HTTP/1.1\r\nHost: %s:%d\r\n"pheadbuffer"",
-             (char*)version, partition_name, server_ip, server_port, ota_key);
 
-    // search partition
+    // search partition, it is erased after the response header is received
     if (upgrade_type == AT_UPGRADE_SYSTEM_FIRMWARE) {  // search ota partition
 #if defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED) && defined(CONFIG_ENABLE_LEGACY_ESP_BOOTLOADER_PLUS_V2_SUPPORT)
-        if (at_compress_ota_begin(&handle) != ESP_OK) {
+        target_partition = at_compress_ota_partition_get();
+        if (target_partition == NULL) {
             goto OTA_ERROR;
         }
 #else
@@ -413,11 +574,7 @@ bool esp_at_upgrade_process(at_ota_mode_t ota_mode, uint8_t *version, const char
         }
 
         memcpy(&partition, partition_ptr, sizeof(esp_partition_t));
-        if (esp_ota_begin(&partition, OTA_SIZE_UNKNOWN, &out_handle) != ESP_OK) {
-            ESP_AT_LOGE(TAG, "esp_ota_begin failed");
-            goto OTA_ERROR;
-        }
-        ESP_AT_LOGI(TAG, "ready to upgrade system firmware...");
+        target_partition = &partition;
 #endif
     } else {    // custom partition
         at_custom_partition = esp_at_custom_partition_find(0x0, 0x0, partition_name);
@@ -428,168 +585,225 @@ bool esp_at_upgrade_process(at_ota_mode_t ota_mode, uint8_t *version, const char
         ESP_AT_LOGI(TAG, "ready to upgrade partition: \"%s\" type:0x%x subtype:0x%x addr:0x%x size:0x%x encrypt:%d",
                     at_custom_partition->label, at_custom_partition->type, at_custom_partition->subtype,
                     at_custom_partition->address, at_custom_partition->size, at_custom_partition->encrypted);
-        if (esp_partition_erase_range(at_custom_partition, 0, at_custom_partition->size) != ESP_OK) {
-            ESP_AT_LOGE(TAG, "esp_partition_erase_range failed");
-            goto OTA_ERROR;
-        }
+        target_partition = at_custom_partition;
     }
 
-    if (ota_mode == ESP_AT_OTA_MODE_NORMAL) {
-        esp_at_ota_socket_id = socket(AF_INET, SOCK_STREAM, 0);
-        if (esp_at_ota_socket_id < 0) {
-            goto OTA_ERROR;
-        }
-        setsockopt(esp_at_ota_socket_id, SOL_SOCKET, SO_REUSEADDR, &sockopt, sizeof(sockopt));
-        if (connect(esp_at_ota_socket_id, (struct sockaddr *)&sock_info, sizeof(sock_info)) < 0) {
-            ESP_AT_LOGE(TAG, "connect to ota server failed");
-            goto OTA_ERROR;
-        }
+    request_len = snprintf((char*)http_request, TEXT_BUFFSIZE,
+                           "GET /v1/device/rom/?action=download_rom&version=%s&filename=%s.bin HTTP/1.1\r\nHost: %s:%d\r\n",
+                           (char*)version, partition_name, server_ip, server_port);
+#ifdef CONFIG_AT_OTA_RESUME_SUPPORT
+    // the request line and the host identify the firmware, request the missing range only if it has been partly downloaded
+    resume_offset = at_ota_resume_lookup(&resume, (char*)http_request, target_partition);
+    if (resume_offset > 0) {
+        request_len += snprintf((char*)http_request + request_len, TEXT_BUFFSIZE - request_len, "Range: bytes=%u-\r\n", resume_offset);
     }
-#ifdef CONFIG_AT_OTA_SSL_SUPPORT
-    else if (ota_mode == ESP_AT_OTA_MODE_SSL) {
-        if (tls) {
-            esp_tls_conn_destroy(tls);
-        }
-        tls = esp_tls_init();
-        if (!tls_cfg) {
-            tls_cfg = (esp_tls_cfg_t *)calloc(1, sizeof(esp_tls_cfg_t));
-        } else {
-            memset(tls_cfg, 0x0, sizeof(esp_tls_cfg_t));
-        }
-        if (tls == NULL || tls_cfg == NULL) {
+#endif
+    snprintf((char*)http_request + request_len, TEXT_BUFFSIZE - request_len, pheadbuffer, ota_key);
+
+    // reuse the connection of the version query if the server keeps it alive
+    bool conn_reused = (esp_at_ota_socket_id >= 0 || tls != NULL);
+    if (!conn_reused) {
+        if (at_ota_conn_open(ota_mode, &sock_info, server_ip, server_port, &tls) != ESP_OK) {
             goto OTA_ERROR;
         }
+    }
 
-        if (esp_tls_conn_new_sync(server_ip, strlen(server_ip), server_port, tls_cfg, tls) < 0) {
-            ESP_AT_LOGE(TAG, "connect to ota server failed");
+    result = at_ota_conn_write(ota_mode, tls, http_request, strlen((char*)http_request));
+    if (result != strlen((char *)http_request) && conn_reused) {
+        // the server may have closed the idle connection, retry on a new one
+        at_ota_conn_close(&tls);
+        if (at_ota_conn_open(ota_mode, &sock_info, server_ip, server_port, &tls) != ESP_OK) {
             goto OTA_ERROR;
         }
+        result = at_ota_conn_write(ota_mode, tls, http_request, strlen((char*)http_request));
     }
-#endif
-    result = -1;
-    if (ota_mode == ESP_AT_OTA_MODE_NORMAL) {
-        result = write(esp_at_ota_socket_id, http_request, strlen((char*)http_request));
-    }
-#ifdef CONFIG_AT_OTA_SSL_SUPPORT
-    else if (ota_mode == ESP_AT_OTA_MODE_SSL) {
-        result = esp_tls_conn_write(tls, (const unsigned char *)http_request, strlen((char *)http_request));
-    }
-#endif
-
     if (result != strlen((char *)http_request)) {
         ESP_AT_LOGE(TAG, "send http request failed");
         goto OTA_ERROR;
     }
-    /*deal with all receive packet*/
-    for (;;) {
-        memset(data_buffer, 0x0, TEXT_BUFFSIZE);
 
-        buff_len = -1;
-        if (ota_mode == ESP_AT_OTA_MODE_NORMAL) {
-            buff_len = read(esp_at_ota_socket_id, data_buffer, TEXT_BUFFSIZE);
-        }
-#ifdef CONFIG_AT_OTA_SSL_SUPPORT
-        else if (ota_mode == ESP_AT_OTA_MODE_SSL) {
-            buff_len = esp_tls_conn_read(tls, data_buffer, TEXT_BUFFSIZE);
-        }
+    /*deal with the response header*/
+    if (at_ota_http_header_recv(ota_mode, tls, &parser, data_buffer, TEXT_BUFFSIZE, &pStr, &body_len) != ESP_OK) {
+        goto OTA_ERROR;
+    }
+    status_code = parser.status_code;
+    if (status_code != 200 && status_code != AT_HTTP_STATUS_PARTIAL_CONTENT) {
+        ESP_AT_LOGE(TAG, "http status: %d", status_code);
+        goto OTA_ERROR;
+    }
+    // -1: the length is unknown, e.g., the body is chunked
+    total_len = parser.content_len;
+    ESP_AT_LOGI(TAG, "total_len=%d!\r\n", total_len);
+
+    // the server which does not support the range request sends the whole firmware
+    if (status_code != AT_HTTP_STATUS_PARTIAL_CONTENT) {
+        resume_offset = 0;
+    }
+#ifdef CONFIG_AT_OTA_RESUME_SUPPORT
+    else if (total_len < 0 || resume_offset + total_len != resume.total_len) {
+        // the firmware on the server has been changed since the download was interrupted
+        ESP_AT_LOGE(TAG, "unmatched ota bin size, %d != %d", resume_offset + total_len, resume.total_len);
+        at_ota_resume_clear();
+        goto OTA_ERROR;
+    }
+    at_ota_resume_start(&resume, resume_offset, total_len >= 0 ? resume_offset + total_len : 0);
+    writer.resume = &resume;
 #endif
-        if (buff_len < 0) {
-            ESP_AT_LOGE(TAG, "recv data failed");
-            goto OTA_ERROR;
-        } else if (buff_len > 0 && !pkg_body_start) {
-            // search "\r\n\r\n"
-            pStr = (uint8_t*)strstr((char*)data_buffer, "Content-Length: ");
-            if (pStr == NULL) {
-                break;
-            }
-            pStr += strlen("Content-Length: ");
-            total_len = atoi((char*)pStr);
-            ESP_AT_LOGI(TAG, "total_len=%d!\r\n", total_len);
-            uint32_t partition_size = 0;
-            if (upgrade_type == AT_UPGRADE_SYSTEM_FIRMWARE) {
+    if (total_len >= 0 && resume_offset + total_len > target_partition->size) {
+        ESP_AT_LOGE(TAG, "ota bin oversize, %d > %d", resume_offset + total_len, target_partition->size);
+        goto OTA_ERROR;
+    }
+
+    // prepare the partition
+    if (upgrade_type == AT_UPGRADE_SYSTEM_FIRMWARE) {
 #if defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED) && defined(CONFIG_ENABLE_LEGACY_ESP_BOOTLOADER_PLUS_V2_SUPPORT)
-                partition_size = handle.partition->size;
+        if (at_compress_ota_begin_with_offset(&handle, resume_offset) != ESP_OK) {
+            goto OTA_ERROR;
+        }
 #else
-                partition_size = partition.size;
-#endif
-            } else {
-                partition_size = at_custom_partition->size;
+        if (resume_offset == 0) {
+            if (esp_ota_begin(&partition, OTA_SIZE_UNKNOWN, &out_handle) != ESP_OK) {
+                ESP_AT_LOGE(TAG, "esp_ota_begin failed");
+                goto OTA_ERROR;
             }
-            if (total_len > partition_size) {
-                ESP_AT_LOGE(TAG, "ota bin oversize, %d > %d", total_len, partition_size);
+        } else {
+            // continue the interrupted download by raw writes, the image is verified by esp_ota_set_boot_partition()
+            if (at_ota_partition_erase(&partition, resume_offset) != ESP_OK) {
                 goto OTA_ERROR;
             }
-            pStr = (uint8_t*)strstr((char*)data_buffer, "\r\n\r\n");
-            if (pStr) {
-                pkg_body_start = true;
-                pStr += 4; // skip "\r\n"
-                buff_len -= (pStr - data_buffer);
-
-                if (at_partition_verify(partition_name, pStr, buff_len) != ESP_OK) {
-                    goto OTA_ERROR;
-                }
+            writer.raw_partition = &partition;
+        }
+        ESP_AT_LOGI(TAG, "ready to upgrade system firmware...");
+#endif
+    } else {
+        if (at_ota_partition_erase(at_custom_partition, resume_offset) != ESP_OK) {
+            goto OTA_ERROR;
+        }
+        writer.raw_partition = at_custom_partition;
+    }
+    if (resume_offset > 0) {
+        ESP_AT_LOGI(TAG, "resume the download from %d", resume_offset);
+    }
 
-                if (upgrade_type == AT_UPGRADE_SYSTEM_FIRMWARE) {
+    /*deal with the response body: the flash-writer task writes the filled buffers while the next one is being received*/
+    writer.upgrade_type = upgrade_type;
+    writer.offset = resume_offset;
 #if defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED) && defined(CONFIG_ENABLE_LEGACY_ESP_BOOTLOADER_PLUS_V2_SUPPORT)
-                    if (at_compress_ota_write(&handle, pStr, buff_len) != ESP_OK) {
-                        goto OTA_ERROR;
-                    }
+    writer.compress_handle = &handle;
 #else
-                    if (esp_ota_write(out_handle, (const void *)pStr, buff_len) != ESP_OK) {
-                        ESP_AT_LOGE(TAG, "esp_ota_write failed");
-                        goto OTA_ERROR;
-                    }
+    writer.ota_handle = out_handle;
 #endif
-                } else {
-                    if (esp_partition_write(at_custom_partition, recv_len, pStr, buff_len) != ESP_OK) {
-                        ESP_AT_LOGE(TAG, "esp_partition_write failed");
-                        goto OTA_ERROR;
-                    }
-                }
+    at_ota_pipeline_config_t pipeline_config = {
+        .buffer_size = CONFIG_AT_OTA_PIPELINE_BUFFER_SIZE,
+        .buffer_num = CONFIG_AT_OTA_PIPELINE_BUFFER_NUM,
+        .write_fn = at_ota_flash_write,
+        .arg = &writer,
+    };
+    if (at_ota_pipeline_create(&pipeline_config, &pipeline) != ESP_OK) {
+        ESP_AT_LOGE(TAG, "at_ota_pipeline_create failed");
+        goto OTA_ERROR;
+    }
 
-                recv_len += buff_len;
-            }
-        } else if (buff_len > 0 && pkg_body_start) {
-            if (upgrade_type == AT_UPGRADE_SYSTEM_FIRMWARE) {
-#if defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED) && defined(CONFIG_ENABLE_LEGACY_ESP_BOOTLOADER_PLUS_V2_SUPPORT)
-                if (at_compress_ota_write(&handle, data_buffer, buff_len) != ESP_OK) {
-                    goto OTA_ERROR;
-                }
-#else
-                if (esp_ota_write(out_handle, (const void *)data_buffer, buff_len) != ESP_OK) {
-                    ESP_AT_LOGE(TAG, "esp_ota_write failed");
-                    goto OTA_ERROR;
-                }
+    // the magic is at the beginning of the firmware, it has been verified if the download is resumed
+    bool body_verified = (resume_offset > 0);
+    bool recv_done = false;
+#ifdef CONFIG_AT_OTA_PROGRESS_REPORT
+    TickType_t report_tick = xTaskGetTickCount();
 #endif
-            } else {
-                if (esp_partition_write(at_custom_partition, recv_len, data_buffer, buff_len) != ESP_OK) {
-                    ESP_AT_LOGE(TAG, "esp_partition_write failed");
-                    goto OTA_ERROR;
-                }
+    while (!at_ota_http_body_done(&parser) && !recv_done) {
+        uint32_t buffer_size = 0;
+        uint8_t *buffer = at_ota_pipeline_buffer_get(pipeline, &buffer_size);
+        if (buffer == NULL) {
+            goto OTA_ERROR;
+        }
+
+        // the body data which has been received with the response header
+        uint32_t fill_len = 0;
+        if (body_len > 0) {
+            uint32_t copy_len = at_min(body_len, buffer_size);
+            memcpy(buffer, pStr, copy_len);
+            pStr += copy_len;
+            body_len -= copy_len;
+            buff_len = at_ota_http_parse_body(&parser, buffer, copy_len);
+            if (buff_len < 0) {
+                at_ota_pipeline_buffer_commit(pipeline, buffer, 0);
+                goto OTA_ERROR;
             }
+            fill_len = buff_len;
+        }
+
+        while (fill_len < buffer_size && body_len == 0 && !at_ota_http_body_done(&parser)) {
+            buff_len = at_ota_conn_read(ota_mode, tls, buffer + fill_len, at_ota_http_body_read_len(&parser, buffer_size - fill_len));
+            if (buff_len < 0) {
+                ESP_AT_LOGE(TAG, "recv data failed");
+                at_ota_pipeline_buffer_commit(pipeline, buffer, 0);
+                goto OTA_ERROR;
+            } else if (buff_len == 0) {
+                ESP_AT_LOGI(TAG, "receive all packet over");
+                at_ota_http_conn_closed(&parser);
+                recv_done = true;
+                break;
+            }
+            // remove the chunked framing in place
+            buff_len = at_ota_http_parse_body(&parser, buffer + fill_len, buff_len);
+            if (buff_len < 0) {
+                at_ota_pipeline_buffer_commit(pipeline, buffer, 0);
+                goto OTA_ERROR;
+            }
+            fill_len += buff_len;
+        }
 
-            recv_len += buff_len;
-        } else if (buff_len == 0) {
-            ESP_AT_LOGI(TAG, "receive all packet over");
-            if (recv_len != total_len) {
+        if (!body_verified && fill_len > 0) {
+            if (at_partition_verify(partition_name, buffer, fill_len) != ESP_OK) {
+                at_ota_pipeline_buffer_commit(pipeline, buffer, 0);
                 goto OTA_ERROR;
             }
+            body_verified = true;
+        }
+
+        if (at_ota_pipeline_buffer_commit(pipeline, buffer, fill_len) != ESP_OK) {
+            goto OTA_ERROR;
+        }
+        recv_len += fill_len;
+        if (total_len > 0) {
+            ESP_AT_LOGI(TAG, "total_len=%d(%d), %d%%!", total_len, recv_len, (int)((uint64_t)recv_len * 100 / total_len));
         } else {
-            ESP_AT_LOGW(TAG, "unhandled event");
+            ESP_AT_LOGI(TAG, "recv_len=%d", recv_len);
         }
-        ESP_AT_LOGI(TAG, "total_len=%d(%d), %0.1f%%!", total_len, recv_len, (recv_len * 1.0) * 100 / total_len);
-        if (recv_len == total_len) {
-            break;
+
+#ifdef CONFIG_AT_OTA_PROGRESS_REPORT
+        if ((xTaskGetTickCount() - report_tick) >= pdMS_TO_TICKS(ESP_AT_OTA_PROGRESS_INTERVAL_MS)) {
+            report_tick = xTaskGetTickCount();
+            at_ota_progress_report(pipeline, resume_offset + recv_len, total_len >= 0 ? resume_offset + total_len : 0);
         }
+#endif
     }
 
+    if (at_ota_pipeline_finish(pipeline) != ESP_OK) {
+        goto OTA_ERROR;
+    }
+    if (!at_ota_http_body_done(&parser) || recv_len == 0) {
+        ESP_AT_LOGE(TAG, "incomplete ota bin, %d < %d", recv_len, total_len);
+        goto OTA_ERROR;
+    }
+#ifdef CONFIG_AT_OTA_RESUME_SUPPORT
+    // the firmware has been completely written, it is not resumed whether it is valid or not
+    at_ota_resume_clear();
+#endif
+#ifdef CONFIG_AT_OTA_PROGRESS_REPORT
+    at_ota_progress_report(pipeline, resume_offset + recv_len, resume_offset + recv_len);
+#endif
+    at_ota_pipeline_destroy(pipeline);
+    pipeline = NULL;
+
     if (upgrade_type == AT_UPGRADE_SYSTEM_FIRMWARE) {
 #if defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED) && defined(CONFIG_ENABLE_LEGACY_ESP_BOOTLOADER_PLUS_V2_SUPPORT)
         if (at_compress_ota_end(&handle) != ESP_OK) {
             goto OTA_ERROR;
         }
 #else
-        if (esp_ota_end(out_handle) != ESP_OK) {
+        // the resumed firmware is written without the ota handle
+        if (!writer.raw_partition && esp_ota_end(out_handle) != ESP_OK) {
             ESP_AT_LOGE(TAG, "esp_ota_end failed");
             goto OTA_ERROR;
         }
@@ -605,16 +819,17 @@ bool esp_at_upgrade_process(at_ota_mode_t ota_mode, uint8_t *version, const char
 
     ret = true;
 OTA_ERROR:
+    // stop the flash-writer before the resources it uses are released
+    at_ota_pipeline_destroy(pipeline);
+    pipeline = NULL;
+
     if (esp_at_ota_timeout_timer != NULL) {
         xTimerStop(esp_at_ota_timeout_timer, portMAX_DELAY);
         xTimerDelete(esp_at_ota_timeout_timer, portMAX_DELAY);
         esp_at_ota_timeout_timer = NULL;
     }
 
-    if (esp_at_ota_socket_id >= 0) {
-        close(esp_at_ota_socket_id);
-        esp_at_ota_socket_id = -1;
-    }
+    at_ota_conn_close(&tls);
 
     if (http_request) {
         free(http_request);
@@ -626,14 +841,6 @@ OTA_ERROR:
         data_buffer = NULL;
     }
 
-#ifdef CONFIG_AT_OTA_SSL_SUPPORT
-    if (tls_cfg) {
-        free(tls_cfg);
-    }
-
-    esp_tls_conn_destroy(tls);
-    tls = NULL;
-#endif
     return ret;
 }
 
@@ -0,0 +1,229 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "sdkconfig.h"
+
+#include "esp_log.h"
+#include "esp_at.h"
+#include "at_ota_http.h"
+
+// static variables
+static const char *TAG = "at-ota-http";
+
+void at_ota_http_parser_init(at_ota_http_parser_t *parser)
+{
+    memset(parser, 0, sizeof(at_ota_http_parser_t));
+    parser->state = AT_OTA_HTTP_STATE_STATUS_LINE;
+    parser->content_len = -1;
+}
+
+/**
+ * @brief Assemble a line, the trailing CRLF is removed.
+ *
+ * @return true if a line is complete
+ */
+static bool at_ota_http_line_feed(at_ota_http_parser_t *parser, uint8_t c)
+{
+    if (c == '\n') {
+        if (parser->line_len > 0 && parser->line[parser->line_len - 1] == '\r') {
+            parser->line_len--;
+        }
+        parser->line[parser->line_len] = '\0';
+        return true;
+    }
+
+    if (parser->line_len < AT_OTA_HTTP_LINE_LEN_MAX) {
+        parser->line[parser->line_len++] = c;
+    }
+    return false;
+}
+
+static const char *at_ota_http_header_value(const char *line, const char *name)
+{
+    size_t name_len = strlen(name);
+    if (strncasecmp(line, name, name_len) || line[name_len] != ':') {
+        return NULL;
+    }
+
+    const char *value = line + name_len + 1;
+    while (*value == ' ' || *value == '\t') {
+        value++;
+    }
+    return value;
+}
+
+static bool at_ota_http_value_has_token(const char *value, const char *token)
+{
+    size_t token_len = strlen(token);
+    for (const char *p = value; *p; p++) {
+        if (!strncasecmp(p, token, token_len)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int at_ota_http_status_line_parse(at_ota_http_parser_t *parser)
+{
+    // HTTP/1.x 200 OK
+    if (strncmp(parser->line, "HTTP/1.", strlen("HTTP/1.")) || !isdigit((int)parser->line[7])) {
+        ESP_AT_LOGE(TAG, "invalid status line: %s", parser->line);
+        return -1;
+    }
+    const char *code = strchr(parser->line, ' ');
+    if (!code) {
+        ESP_AT_LOGE(TAG, "invalid status line: %s", parser->line);
+        return -1;
+    }
+
+    parser->status_code = atoi(code + 1);
+    // the connection of HTTP/1.1 is persistent by default
+    parser->keep_alive = (parser->line[7] != '0');
+    return 0;
+}
+
+static void at_ota_http_header_line_parse(at_ota_http_parser_t *parser)
+{
+    const char *value = NULL;
+
+    if ((value = at_ota_http_header_value(parser->line, "Content-Length")) != NULL) {
+        parser->content_len = atoi(value);
+    } else if ((value = at_ota_http_header_value(parser->line, "Transfer-Encoding")) != NULL) {
+        parser->chunked = at_ota_http_value_has_token(value, "chunked");
+    } else if ((value = at_ota_http_header_value(parser->line, "Connection")) != NULL) {
+        if (at_ota_http_value_has_token(value, "close")) {
+            parser->keep_alive = false;
+        } else if (at_ota_http_value_has_token(value, "keep-alive")) {
+            parser->keep_alive = true;
+        }
+    }
+}
+
+static void at_ota_http_header_end(at_ota_http_parser_t *parser)
+{
+    if (parser->status_code == 204 || parser->status_code == 304) {
+        // no body
+        parser->state = AT_OTA_HTTP_STATE_DONE;
+    } else if (parser->chunked) {
+        // Content-Length is ignored if the body is chunked
+        parser->content_len = -1;
+        parser->state = AT_OTA_HTTP_STATE_CHUNK_SIZE;
+    } else if (parser->content_len >= 0) {
+        parser->remain_len = parser->content_len;
+        parser->state = parser->content_len > 0 ? AT_OTA_HTTP_STATE_BODY : AT_OTA_HTTP_STATE_DONE;
+    } else {
+        // the body is delimited by closing the connection
+        parser->keep_alive = false;
+        parser->state = AT_OTA_HTTP_STATE_BODY;
+    }
+}
+
+int at_ota_http_parse_header(at_ota_http_parser_t *parser, const uint8_t *data, int len)
+{
+    int i = 0;
+
+    while (i < len && !at_ota_http_header_done(parser)) {
+        if (!at_ota_http_line_feed(parser, data[i++])) {
+            continue;
+        }
+
+        if (parser->state == AT_OTA_HTTP_STATE_STATUS_LINE) {
+            if (at_ota_http_status_line_parse(parser) < 0) {
+                return -1;
+            }
+            parser->state = AT_OTA_HTTP_STATE_HEADER;
+        } else if (parser->line_len == 0) {
+            at_ota_http_header_end(parser);
+        } else {
+            at_ota_http_header_line_parse(parser);
+        }
+        parser->line_len = 0;
+    }
+
+    return i;
+}
+
+int at_ota_http_parse_body(at_ota_http_parser_t *parser, uint8_t *data, int len)
+{
+    int i = 0;
+    int out_len = 0;
+
+    while (i < len && parser->state != AT_OTA_HTTP_STATE_DONE) {
+        switch (parser->state) {
+        case AT_OTA_HTTP_STATE_BODY: {
+            uint32_t data_len = len - i;
+            if (parser->content_len >= 0) {
+                data_len = at_min(data_len, parser->remain_len);
+                parser->remain_len -= data_len;
+                if (parser->remain_len == 0) {
+                    parser->state = AT_OTA_HTTP_STATE_DONE;
+                }
+            }
+            memmove(data + out_len, data + i, data_len);
+            out_len += data_len;
+            i += data_len;
+            break;
+        }
+
+        case AT_OTA_HTTP_STATE_CHUNK_DATA: {
+            uint32_t data_len = at_min(len - i, parser->remain_len);
+            memmove(data + out_len, data + i, data_len);
+            out_len += data_len;
+            i += data_len;
+            parser->remain_len -= data_len;
+            if (parser->remain_len == 0) {
+                parser->state = AT_OTA_HTTP_STATE_CHUNK_DATA_END;
+            }
+            break;
+        }
+
+        default:
+            // the chunk size line, the CRLF after the chunk data and the trailer lines
+            if (!at_ota_http_line_feed(parser, data[i++])) {
+                break;
+            }
+            if (parser->state == AT_OTA_HTTP_STATE_CHUNK_SIZE) {
+                char *end = NULL;
+                parser->remain_len = strtoul(parser->line, &end, 16);
+                if (end == parser->line) {
+                    ESP_AT_LOGE(TAG, "invalid chunk size: %s", parser->line);
+                    return -1;
+                }
+                parser->state = parser->remain_len ? AT_OTA_HTTP_STATE_CHUNK_DATA : AT_OTA_HTTP_STATE_TRAILER;
+            } else if (parser->state == AT_OTA_HTTP_STATE_CHUNK_DATA_END) {
+                parser->state = AT_OTA_HTTP_STATE_CHUNK_SIZE;
+            } else if (parser->line_len == 0) {
+                // the empty line after the trailer
+                parser->state = AT_OTA_HTTP_STATE_DONE;
+            }
+            parser->line_len = 0;
+            break;
+        }
+    }
+
+    return out_len;
+}
+
+uint32_t at_ota_http_body_read_len(const at_ota_http_parser_t *parser, uint32_t max_len)
+{
+    if (parser->state == AT_OTA_HTTP_STATE_BODY && parser->content_len >= 0) {
+        return at_min(max_len, parser->remain_len);
+    }
+    return max_len;
+}
+
+bool at_ota_http_conn_closed(at_ota_http_parser_t *parser)
+{
+    parser->keep_alive = false;
+    if (parser->state == AT_OTA_HTTP_STATE_BODY && parser->content_len < 0) {
+        parser->state = AT_OTA_HTTP_STATE_DONE;
+    }
+
+    return at_ota_http_body_done(parser);
+}
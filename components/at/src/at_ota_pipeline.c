@@ -0,0 +1,229 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_at.h"
+#include "at_ota_pipeline.h"
+
+#define AT_OTA_PIPELINE_TASK_STACK_SIZE         4096
+
+typedef enum {
+    AT_OTA_PIPELINE_ITEM_DATA = 0,          // a filled buffer
+    AT_OTA_PIPELINE_ITEM_FLUSH,             // all the previous buffers are written, notify the downloader
+    AT_OTA_PIPELINE_ITEM_EXIT,              // exit the flash-writer task
+} at_ota_pipeline_item_type_t;
+
+typedef struct {
+    at_ota_pipeline_item_type_t type;
+    uint8_t *buffer;
+    uint32_t len;
+} at_ota_pipeline_item_t;
+
+struct at_ota_pipeline {
+    at_ota_pipeline_config_t config;
+    uint8_t **buffers;
+    QueueHandle_t free_queue;               // the buffers which can be filled by the downloader
+    QueueHandle_t full_queue;               // the items to the flash-writer
+    SemaphoreHandle_t done_sema;            // given by the flash-writer on AT_OTA_PIPELINE_ITEM_FLUSH and AT_OTA_PIPELINE_ITEM_EXIT
+    TaskHandle_t writer;
+    volatile esp_err_t error;               // the first error from the write function
+    portMUX_TYPE stats_lock;
+    uint64_t download_us;
+    uint64_t flash_us;
+    uint32_t download_bytes;
+    uint32_t flash_bytes;
+    int64_t fill_start_us;                  // the time of the last at_ota_pipeline_buffer_get()
+};
+
+// static variables
+static const char *TAG = "at-ota-pipeline";
+
+static void at_ota_pipeline_writer_task(void *params)
+{
+    at_ota_pipeline_handle_t handle = (at_ota_pipeline_handle_t)params;
+    at_ota_pipeline_item_t item;
+
+    for (;;) {
+        if (xQueueReceive(handle->full_queue, &item, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        if (item.type == AT_OTA_PIPELINE_ITEM_EXIT) {
+            break;
+        } else if (item.type == AT_OTA_PIPELINE_ITEM_FLUSH) {
+            xSemaphoreGive(handle->done_sema);
+            continue;
+        }
+
+        // keep draining the items after a failure, so that the downloader is never blocked
+        if (handle->error == ESP_OK && item.len > 0) {
+            int64_t start_us = esp_timer_get_time();
+            esp_err_t ret = handle->config.write_fn(handle->config.arg, item.buffer, item.len);
+            int64_t cost_us = esp_timer_get_time() - start_us;
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "write %u bytes failed: 0x%x", item.len, ret);
+                handle->error = ret;
+            } else {
+                portENTER_CRITICAL(&handle->stats_lock);
+                handle->flash_us += cost_us;
+                handle->flash_bytes += item.len;
+                portEXIT_CRITICAL(&handle->stats_lock);
+            }
+        }
+
+        xQueueSend(handle->free_queue, &item.buffer, portMAX_DELAY);
+    }
+
+    // the handle must not be touched after the semaphore is given
+    xSemaphoreGive(handle->done_sema);
+    vTaskDelete(NULL);
+}
+
+esp_err_t at_ota_pipeline_create(const at_ota_pipeline_config_t *config, at_ota_pipeline_handle_t *handle)
+{
+    if (!config || !handle || !config->write_fn || config->buffer_num < 2 || config->buffer_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    at_ota_pipeline_handle_t pipeline = (at_ota_pipeline_handle_t)calloc(1, sizeof(struct at_ota_pipeline));
+    if (!pipeline) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(&pipeline->config, config, sizeof(at_ota_pipeline_config_t));
+    portMUX_INITIALIZE(&pipeline->stats_lock);
+
+    pipeline->buffers = (uint8_t **)calloc(config->buffer_num, sizeof(uint8_t *));
+    pipeline->free_queue = xQueueCreate(config->buffer_num, sizeof(uint8_t *));
+    pipeline->full_queue = xQueueCreate(config->buffer_num + 1, sizeof(at_ota_pipeline_item_t));
+    pipeline->done_sema = xSemaphoreCreateBinary();
+    if (!pipeline->buffers || !pipeline->free_queue || !pipeline->full_queue || !pipeline->done_sema) {
+        goto err;
+    }
+
+    for (uint32_t i = 0; i < config->buffer_num; ++i) {
+        pipeline->buffers[i] = (uint8_t *)malloc(config->buffer_size);
+        if (!pipeline->buffers[i]) {
+            ESP_LOGE(TAG, "no memory for %u x %u bytes", config->buffer_num, config->buffer_size);
+            goto err;
+        }
+        xQueueSend(pipeline->free_queue, &pipeline->buffers[i], 0);
+    }
+
+    // the flash-writer runs at the same priority as the downloader, they take turns while the other one is blocked
+    if (xTaskCreate(at_ota_pipeline_writer_task, "ota_writer", AT_OTA_PIPELINE_TASK_STACK_SIZE, pipeline,
+                    uxTaskPriorityGet(NULL), &pipeline->writer) != pdPASS) {
+        ESP_LOGE(TAG, "create flash-writer task failed");
+        goto err;
+    }
+
+    *handle = pipeline;
+    return ESP_OK;
+
+err:
+    at_ota_pipeline_destroy(pipeline);
+    return ESP_ERR_NO_MEM;
+}
+
+uint8_t *at_ota_pipeline_buffer_get(at_ota_pipeline_handle_t handle, uint32_t *size)
+{
+    uint8_t *buffer = NULL;
+
+    if (handle->error != ESP_OK) {
+        return NULL;
+    }
+    if (xQueueReceive(handle->free_queue, &buffer, portMAX_DELAY) != pdTRUE) {
+        return NULL;
+    }
+    if (handle->error != ESP_OK) {
+        xQueueSend(handle->free_queue, &buffer, 0);
+        return NULL;
+    }
+
+    if (size) {
+        *size = handle->config.buffer_size;
+    }
+    handle->fill_start_us = esp_timer_get_time();
+    return buffer;
+}
+
+esp_err_t at_ota_pipeline_buffer_commit(at_ota_pipeline_handle_t handle, uint8_t *buffer, uint32_t len)
+{
+    int64_t cost_us = esp_timer_get_time() - handle->fill_start_us;
+    portENTER_CRITICAL(&handle->stats_lock);
+    handle->download_us += cost_us;
+    handle->download_bytes += len;
+    portEXIT_CRITICAL(&handle->stats_lock);
+
+    at_ota_pipeline_item_t item = {
+        .type = AT_OTA_PIPELINE_ITEM_DATA,
+        .buffer = buffer,
+        .len = len,
+    };
+    xQueueSend(handle->full_queue, &item, portMAX_DELAY);
+
+    return handle->error;
+}
+
+esp_err_t at_ota_pipeline_finish(at_ota_pipeline_handle_t handle)
+{
+    at_ota_pipeline_item_t item = {
+        .type = AT_OTA_PIPELINE_ITEM_FLUSH,
+    };
+    xQueueSend(handle->full_queue, &item, portMAX_DELAY);
+    xSemaphoreTake(handle->done_sema, portMAX_DELAY);
+
+    return handle->error;
+}
+
+void at_ota_pipeline_stats_get(at_ota_pipeline_handle_t handle, at_ota_pipeline_stats_t *stats)
+{
+    portENTER_CRITICAL(&handle->stats_lock);
+    stats->download_bytes = handle->download_bytes;
+    stats->download_ms = handle->download_us / 1000;
+    stats->flash_bytes = handle->flash_bytes;
+    stats->flash_ms = handle->flash_us / 1000;
+    portEXIT_CRITICAL(&handle->stats_lock);
+}
+
+void at_ota_pipeline_destroy(at_ota_pipeline_handle_t handle)
+{
+    if (!handle) {
+        return;
+    }
+
+    if (handle->writer) {
+        at_ota_pipeline_item_t item = {
+            .type = AT_OTA_PIPELINE_ITEM_EXIT,
+        };
+        xQueueSend(handle->full_queue, &item, portMAX_DELAY);
+        xSemaphoreTake(handle->done_sema, portMAX_DELAY);
+    }
+
+    if (handle->buffers) {
+        for (uint32_t i = 0; i < handle->config.buffer_num; ++i) {
+            free(handle->buffers[i]);
+        }
+        free(handle->buffers);
+    }
+    if (handle->free_queue) {
+        vQueueDelete(handle->free_queue);
+    }
+    if (handle->full_queue) {
+        vQueueDelete(handle->full_queue);
+    }
+    if (handle->done_sema) {
+        vSemaphoreDelete(handle->done_sema);
+    }
+    free(handle);
+}
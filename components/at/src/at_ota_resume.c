@@ -0,0 +1,135 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include "sdkconfig.h"
+
+#ifdef CONFIG_AT_OTA_RESUME_SUPPORT
+#include "nvs.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "spi_flash_mmap.h"
+#include "esp_at.h"
+#include "at_ota_resume.h"
+
+#define AT_OTA_RESUME_NAMESPACE             "at_ota"
+#define AT_OTA_RESUME_KEY                   "resume"
+
+typedef struct {
+    uint32_t id;                            // the identity of the download source
+    uint32_t address;                       // the address of the partition
+    uint32_t total_len;                     // the total length of the image
+    uint32_t written_len;                   // the sector-aligned length of data which has been written
+} at_ota_resume_record_t;
+
+// static variables
+static const char *TAG = "at-ota-resume";
+
+static bool at_ota_resume_record_get(at_ota_resume_record_t *record)
+{
+    nvs_handle_t handle;
+    if (nvs_open(AT_OTA_RESUME_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+
+    size_t len = sizeof(at_ota_resume_record_t);
+    esp_err_t ret = nvs_get_blob(handle, AT_OTA_RESUME_KEY, record, &len);
+    nvs_close(handle);
+
+    return (ret == ESP_OK && len == sizeof(at_ota_resume_record_t));
+}
+
+static void at_ota_resume_record_set(const at_ota_resume_record_t *record)
+{
+    nvs_handle_t handle;
+    if (nvs_open(AT_OTA_RESUME_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGW(TAG, "nvs open failed");
+        return;
+    }
+
+    // the record is written to NVS directly, not through the write-back cache of esp_at_nvs_set_blob(),
+    // since it must survive the power loss during the download
+    esp_err_t ret = ESP_OK;
+    if (record) {
+        ret = nvs_set_blob(handle, AT_OTA_RESUME_KEY, record, sizeof(at_ota_resume_record_t));
+    } else {
+        ret = nvs_erase_key(handle, AT_OTA_RESUME_KEY);
+        if (ret == ESP_ERR_NVS_NOT_FOUND) {
+            ret = ESP_OK;
+        }
+    }
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "nvs write failed: 0x%x", ret);
+    }
+    nvs_close(handle);
+}
+
+uint32_t at_ota_resume_lookup(at_ota_resume_t *resume, const char *source, const esp_partition_t *partition)
+{
+    memset(resume, 0, sizeof(at_ota_resume_t));
+    resume->partition = partition;
+
+    // the encrypted partition is written in 16-byte blocks by esp_ota_write(), do not resume it by raw writes
+    resume->enabled = (source && partition && !partition->encrypted);
+    if (!resume->enabled) {
+        return 0;
+    }
+    resume->id = esp_rom_crc32_le(0, (const uint8_t *)source, strlen(source));
+
+    at_ota_resume_record_t record;
+    if (!at_ota_resume_record_get(&record)) {
+        return 0;
+    }
+    if (record.id != resume->id || record.address != partition->address
+            || record.written_len >= record.total_len || record.total_len > partition->size) {
+        return 0;
+    }
+
+    uint32_t offset = record.written_len & ~(SPI_FLASH_SEC_SIZE - 1);
+    resume->total_len = record.total_len;
+    ESP_AT_LOGI(TAG, "resume from %d/%d", offset, record.total_len);
+
+    return offset;
+}
+
+void at_ota_resume_start(at_ota_resume_t *resume, uint32_t offset, uint32_t total_len)
+{
+    if (resume->enabled && offset == 0) {
+        at_ota_resume_clear();
+    }
+
+    // the progress of an image with unknown length can not be checked when resuming, do not record it
+    if (total_len == 0) {
+        resume->enabled = false;
+    }
+    resume->total_len = total_len;
+    resume->saved_len = offset;
+}
+
+void at_ota_resume_update(at_ota_resume_t *resume, uint32_t written_len)
+{
+    if (!resume || !resume->enabled || written_len - resume->saved_len < AT_OTA_RESUME_SAVE_INTERVAL) {
+        return;
+    }
+
+    at_ota_resume_record_t record = {
+        .id = resume->id,
+        .address = resume->partition->address,
+        .total_len = resume->total_len,
+        .written_len = written_len & ~(SPI_FLASH_SEC_SIZE - 1),
+    };
+    at_ota_resume_record_set(&record);
+    resume->saved_len = written_len;
+}
+
+void at_ota_resume_clear(void)
+{
+    at_ota_resume_record_set(NULL);
+}
+
+#endif
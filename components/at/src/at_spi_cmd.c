@@ -0,0 +1,55 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+#ifdef CONFIG_AT_BASE_ON_SPI
+#include "esp_timer.h"
+#include "esp_at.h"
+#include "esp_at_interface.h"
+
+// static variables
+static at_spi_stats_t s_last_stats;
+static int64_t s_last_query_us = 0;
+
+static uint8_t at_query_cmd_spistat(uint8_t *cmd_name)
+{
+    at_spi_stats_t stats;
+    at_spi_stats_get(&stats);
+
+    // throughput since the last query (or since boot for the first query)
+    int64_t now_us = esp_timer_get_time();
+    uint32_t elapsed_ms = (now_us - s_last_query_us) / 1000;
+    uint32_t rx_rate = 0, tx_rate = 0;
+    if (elapsed_ms > 0) {
+        rx_rate = (uint64_t)(stats.rx_bytes - s_last_stats.rx_bytes) * 1000 / elapsed_ms;
+        tx_rate = (uint64_t)(stats.tx_bytes - s_last_stats.tx_bytes) * 1000 / elapsed_ms;
+    }
+    memcpy(&s_last_stats, &stats, sizeof(at_spi_stats_t));
+    s_last_query_us = now_us;
+
+    uint8_t buffer[AT_BUFFER_ON_STACK_SIZE] = {0};
+    snprintf((char *)buffer, AT_BUFFER_ON_STACK_SIZE, "%s:%u,%u,%u,%u,%u,%u\r\n",
+             cmd_name, stats.rx_bytes, stats.tx_bytes, stats.rx_trans, stats.tx_trans, rx_rate, tx_rate);
+    esp_at_port_write_data(buffer, strlen((char *)buffer));
+
+    return ESP_AT_RESULT_CODE_OK;
+}
+
+static const esp_at_cmd_struct at_spi_cmd[] = {
+    {"+SPISTAT", NULL, at_query_cmd_spistat, NULL, NULL},
+};
+
+bool esp_at_spi_cmd_regist(void)
+{
+    return esp_at_custom_cmd_array_regist(at_spi_cmd, sizeof(at_spi_cmd) / sizeof(esp_at_cmd_struct));
+}
+
+ESP_AT_CMD_SET_FIRST_INIT_FN(esp_at_spi_cmd_regist, 23);
+
+#endif
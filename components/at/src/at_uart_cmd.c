@@ -163,10 +163,95 @@ static uint8_t at_query_cmd_uart_def(uint8_t *cmd_name)
     return ESP_AT_RESULT_CODE_OK;
 }
 
+static uint8_t at_setup_cmd_uartrxcfg(uint8_t para_num)
+{
+    int32_t value = 0;
+    int32_t cnt = 0;
+
+    at_uart_rx_config_t config;
+    at_uart_rx_config_get(&config);
+
+    // rxfifo_full_thresh
+    if (esp_at_get_para_as_digit(cnt++, &value) != ESP_AT_PARA_PARSE_RESULT_OK) {
+        return ESP_AT_RESULT_CODE_ERROR;
+    }
+    if (value <= 0 || value >= SOC_UART_FIFO_LEN) {
+        return ESP_AT_RESULT_CODE_ERROR;
+    }
+    config.rxfifo_full_thresh = value;
+
+    // rx_timeout_thresh
+    if (esp_at_get_para_as_digit(cnt++, &value) != ESP_AT_PARA_PARSE_RESULT_OK) {
+        return ESP_AT_RESULT_CODE_ERROR;
+    }
+    if (value <= 0 || value > UINT8_MAX) {
+        return ESP_AT_RESULT_CODE_ERROR;
+    }
+    config.rx_timeout_thresh = value;
+
+    // window_ms
+    if (esp_at_get_para_as_digit(cnt++, &value) != ESP_AT_PARA_PARSE_RESULT_OK) {
+        return ESP_AT_RESULT_CODE_ERROR;
+    }
+    if (value < 0 || value > AT_UART_RX_WINDOW_MS_MAX) {
+        return ESP_AT_RESULT_CODE_ERROR;
+    }
+    config.window_ms = value;
+
+    // window_bytes (optional)
+    config.window_bytes = 0;
+    if (cnt < para_num) {
+        if (esp_at_get_para_as_digit(cnt++, &value) != ESP_AT_PARA_PARSE_RESULT_OK) {
+            return ESP_AT_RESULT_CODE_ERROR;
+        }
+        if (value < 0) {
+            return ESP_AT_RESULT_CODE_ERROR;
+        }
+        config.window_bytes = value;
+    }
+
+    if (para_num != cnt) {
+        return ESP_AT_RESULT_CODE_ERROR;
+    }
+
+    if (at_uart_rx_config_set(&config) != ESP_OK) {
+        return ESP_AT_RESULT_CODE_ERROR;
+    }
+
+    return ESP_AT_RESULT_CODE_OK;
+}
+
+static uint8_t at_query_cmd_uartrxcfg(uint8_t *cmd_name)
+{
+    at_uart_rx_config_t config;
+    at_uart_rx_config_get(&config);
+
+    uint8_t buffer[AT_BUFFER_ON_STACK_SIZE] = {0};
+    snprintf((char *)buffer, AT_BUFFER_ON_STACK_SIZE, "%s:%d,%d,%d,%d\r\n",
+             cmd_name, config.rxfifo_full_thresh, config.rx_timeout_thresh, config.window_ms, config.window_bytes);
+    esp_at_port_write_data(buffer, strlen((char *)buffer));
+
+    return ESP_AT_RESULT_CODE_OK;
+}
+
+static uint8_t at_query_cmd_uartstat(uint8_t *cmd_name)
+{
+    at_uart_rx_stats_t stats;
+    at_uart_rx_stats_get(&stats);
+
+    uint8_t buffer[AT_BUFFER_ON_STACK_SIZE] = {0};
+    snprintf((char *)buffer, AT_BUFFER_ON_STACK_SIZE, "%s:%u,%u\r\n", cmd_name, stats.heap_alloc_num, stats.discard_bytes);
+    esp_at_port_write_data(buffer, strlen((char *)buffer));
+
+    return ESP_AT_RESULT_CODE_OK;
+}
+
 static const esp_at_cmd_struct at_uart_cmd[] = {
     {"+UART", NULL, at_query_cmd_uart, at_setup_cmd_uart_def, NULL},
     {"+UART_CUR", NULL, at_query_cmd_uart, at_setup_cmd_uart_cur, NULL},
     {"+UART_DEF", NULL, at_query_cmd_uart_def, at_setup_cmd_uart_def, NULL},
+    {"+UARTRXCFG", NULL, at_query_cmd_uartrxcfg, at_setup_cmd_uartrxcfg, NULL},
+    {"+UARTSTAT", NULL, at_query_cmd_uartstat, NULL, NULL},
 };
 
 bool esp_at_uart_cmd_regist(void)
@@ -22,15 +22,22 @@
 #include "at_compress_ota.h"
 #endif
 
+#ifdef CONFIG_AT_DELTA_OTA_SUPPORT
+#include "at_delta_ota.h"
+#endif
+
 #include "esp_http_client.h"
 #include "esp_https_ota.h"
 #include "esp_at_core.h"
 #include "esp_at.h"
+#include "esp_at_interface.h"
 
 #ifdef CONFIG_AT_USER_COMMAND_SUPPORT
 
 #define AT_USERRAM_READ_BUFFER_SIZE     1024
 #define AT_USEROTA_URL_LEN_MAX          (8 * 1024)
+#define AT_USEROTA_MODE_FULL            0
+#define AT_USEROTA_MODE_DELTA           1
 #define AT_USERDOCS_BUFFER_LEN_MAX      (1024)
 #define AT_DOCS_SERVER_HOSTNAME         "docs.espressif.com"
 #define AT_DOCS_PROJECT_PATH            "projects/esp-at"
@@ -208,21 +215,20 @@ static uint8_t at_setup_cmd_userram(uint8_t para_num)
         if (offset + length > s_user_ram_size) {
             return ESP_AT_RESULT_CODE_ERROR;
         }
-        uint8_t *pbuffer = calloc(1, at_min(AT_USERRAM_READ_BUFFER_SIZE, length) + HEAD_BUFFER_SIZE);
-        if (pbuffer == NULL) {
-            return ESP_AT_RESULT_CODE_ERROR;
-        }
         ESP_AT_LOGI(TAG, "to read %d bytes", length);
 
-        uint32_t head_len = 0, had_read_len = 0, to_read_len = 0;
+        // the header and the user ram are written as one transaction, without copying the user ram
+        uint8_t head[HEAD_BUFFER_SIZE];
+        uint32_t had_read_len = 0, to_read_len = 0;
         do {
             to_read_len = at_min(length - had_read_len, AT_USERRAM_READ_BUFFER_SIZE);
-            head_len = snprintf((char *)pbuffer, HEAD_BUFFER_SIZE, "%s:%d,", esp_at_get_current_cmd_name(), to_read_len);
-            memcpy((char *)pbuffer + head_len, (char *)sp_user_ram + offset + had_read_len, to_read_len);
-            esp_at_port_write_data(pbuffer, head_len + to_read_len);
+            esp_at_iovec_t iov[] = {
+                {head, snprintf((char *)head, HEAD_BUFFER_SIZE, "%s:%d,", esp_at_get_current_cmd_name(), to_read_len)},
+                {sp_user_ram + offset + had_read_len, to_read_len},
+            };
+            esp_at_port_writev(iov, sizeof(iov) / sizeof(iov[0]));
             had_read_len += to_read_len;
         } while (had_read_len < length);
-        free(pbuffer);
 
         break;
     }
@@ -302,6 +308,7 @@ static uint8_t at_setup_cmd_userota(uint8_t para_num)
 #define TEMP_BUFFER_SIZE    32
     uint8_t buffer[TEMP_BUFFER_SIZE] = {0};
     int32_t length = 0;
+    int32_t mode = AT_USEROTA_MODE_FULL;
     int32_t cnt = 0;
 
     // length
@@ -312,6 +319,22 @@ static uint8_t at_setup_cmd_userota(uint8_t para_num)
         return ESP_AT_RESULT_CODE_ERROR;
     }
 
+    // mode
+    if (cnt < para_num) {
+        if (esp_at_get_para_as_digit(cnt++, &mode) != ESP_AT_PARA_PARSE_RESULT_OK) {
+            return ESP_AT_RESULT_CODE_ERROR;
+        }
+    }
+#ifdef CONFIG_AT_DELTA_OTA_SUPPORT
+    if ((mode != AT_USEROTA_MODE_FULL) && (mode != AT_USEROTA_MODE_DELTA)) {
+        return ESP_AT_RESULT_CODE_ERROR;
+    }
+#else
+    if (mode != AT_USEROTA_MODE_FULL) {
+        return ESP_AT_RESULT_CODE_ERROR;
+    }
+#endif
+
     // parameters are ready
     if (cnt != para_num) {
         return ESP_AT_RESULT_CODE_ERROR;
@@ -372,11 +395,19 @@ static uint8_t at_setup_cmd_userota(uint8_t para_num)
 #if defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED) && defined(CONFIG_ENABLE_LEGACY_ESP_BOOTLOADER_PLUS_V2_SUPPORT)
     esp_err_t ret = at_compress_https_ota(&config);
 #else
-    esp_https_ota_config_t ota_config = {
-        .http_config = &config,
-    };
+    esp_err_t ret = ESP_FAIL;
+#ifdef CONFIG_AT_DELTA_OTA_SUPPORT
+    if (mode == AT_USEROTA_MODE_DELTA) {
+        ret = at_delta_https_ota(&config);
+    } else
+#endif
+    {
+        esp_https_ota_config_t ota_config = {
+            .http_config = &config,
+        };
 
-    esp_err_t ret = esp_https_ota(&ota_config);
+        ret = esp_https_ota(&ota_config);
+    }
 #endif
 
     free(url);
@@ -578,6 +609,14 @@ static uint8_t at_setup_cmd_userwkmcucfg(uint8_t para_num)
         return ESP_AT_RESULT_CODE_ERROR;
     }
 
+    // the event group is only used once the MCU wake-up is enabled, create it on the first use
+    if (enable && !s_wkmcu_evt_group) {
+        s_wkmcu_evt_group = xEventGroupCreate();
+        if (!s_wkmcu_evt_group) {
+            return ESP_AT_RESULT_CODE_FAIL;
+        }
+    }
+
     // preset gpio status
     if (enable) {
         if (wk_mode == WKMCU_MODE_GPIO) {
@@ -661,6 +700,13 @@ static uint8_t at_setup_cmd_usermcusleep(uint8_t para_num)
 }
 #endif
 
+#ifdef CONFIG_AT_NVS_WRITE_BACK_CACHE
+static uint8_t at_exe_cmd_usernvsflush(uint8_t *cmd_name)
+{
+    return (esp_at_nvs_flush() == ESP_OK) ? ESP_AT_RESULT_CODE_OK : ESP_AT_RESULT_CODE_ERROR;
+}
+#endif
+
 static const esp_at_cmd_struct s_at_user_cmd[] = {
     {"+USERRAM", NULL, at_query_cmd_userram, at_setup_cmd_userram, NULL},
     {"+USEROTA", NULL, NULL, at_setup_cmd_userota, NULL},
@@ -669,13 +715,13 @@ static const esp_at_cmd_struct s_at_user_cmd[] = {
     {"+USERWKMCUCFG", NULL, NULL, at_setup_cmd_userwkmcucfg, NULL},
     {"+USERMCUSLEEP", NULL, NULL, at_setup_cmd_usermcusleep, NULL},
 #endif
+#ifdef CONFIG_AT_NVS_WRITE_BACK_CACHE
+    {"+USERNVSFLUSH", NULL, NULL, NULL, at_exe_cmd_usernvsflush},
+#endif
 };
 
 bool esp_at_user_cmd_regist(void)
 {
-#ifdef CONFIG_AT_USERWKMCU_COMMAND_SUPPORT
-    s_wkmcu_evt_group = xEventGroupCreate();
-#endif
     return esp_at_custom_cmd_array_regist(s_at_user_cmd, sizeof(s_at_user_cmd) / sizeof(s_at_user_cmd[0]));
 }
 
@@ -13,9 +13,11 @@
 #include <sys/param.h>
 #include <time.h>
 #include <sys/queue.h>
+#include <sys/stat.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/timers.h"
+#include "freertos/semphr.h"
 #include "freertos/event_groups.h"
 #include "lwip/err.h"
 #include "lwip/sockets.h"
@@ -31,6 +33,8 @@
 #include "esp_flash_partitions.h"
 #include "esp_partition.h"
 #include "esp_mac.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
 
 #include "esp_at.h"
 
@@ -76,7 +80,7 @@ static char *s_at_web_redirect_url = NULL;
 #define ESP_AT_WEB_IPV4_MAX_IP_LEN_DEFAULT             32
 #define ESP_AT_WEB_RECEIVED_ACK_MESSAGE                "received"
 #define ESP_AT_WEB_AP_SCAN_NUM_DEFAULT                 10
-#define ESP_AT_WEB_AP_RECORD_JSON_STR_LEN              600
+#define ESP_AT_WEB_AP_RECORD_JSON_MAX_LEN              100    // ",{"ssid":"<escaped ssid>","auth_mode":x}"
 #define ESP_AT_WEB_WIFI_CONNECTED_BIT                  BIT0
 #define ESP_AT_WEB_WIFI_FAIL_BIT                       BIT1
 #define ESP_AT_WEB_SCAN_RSSI_THRESHOLD                 -50
@@ -106,6 +110,12 @@ typedef struct router_obj {
     SLIST_ENTRY(router_obj) next;
 } router_obj_t;
 
+typedef struct {
+    wifi_ap_record_t records[ESP_AT_WEB_SCAN_LIST_SIZE];     /*!< the APs found in the latest scan, sorted by rssi */
+    uint16_t number;                                        /*!< the number of the found APs */
+    int64_t time_us;                                        /*!< the time when the latest scan is done, 0 if the records are invalid */
+} at_web_scan_cache_t;
+
 typedef struct web_server_context {
     char base_path[ESP_VFS_PATH_MAX + 1];
     char scratch[ESP_AT_WEB_SCRATCH_BUFSIZE];
@@ -139,6 +149,8 @@ typedef struct {
 } udp_broadcast_info_t;
 
 static web_server_context_t *s_web_context = NULL;
+static at_web_scan_cache_t *s_scan_cache = NULL;
+static SemaphoreHandle_t s_scan_cache_mutex = NULL;
 static httpd_handle_t s_server = NULL;
 static int32_t s_at_web_wifi_reconnect_timeout = ESP_AT_WEB_WIFI_MAX_RECONNECT_TIMEOUT;
 static wifi_sta_connection_info_t s_wifi_sta_connection_info = {0};
@@ -382,7 +394,72 @@ esp_err_t at_web_wifi_scan_get_ap_records(uint16_t *number, wifi_ap_record_t *ap
     return ESP_OK;
 }
 
-static esp_err_t at_web_check_ap_info(wifi_ap_record_t *ap_info)
+/**
+  * @brief Get the AP list found in the latest scan, a new scan is started only if the list is older than max_age_ms.
+  *
+  * @note The scan cache is locked until at_web_scan_cache_release() is called,
+  *       so the concurrent callers wait for one scan and share its result instead of scanning back to back.
+  *
+  * @param[in]  max_age_ms  the freshness window of the cached list, 0 to always start a new scan
+  * @param[out] ap_records  the cached AP list sorted by rssi
+  * @param[out] number      the number of the cached APs
+  *
+  * @return
+  *    - ESP_OK: succeed, at_web_scan_cache_release() should be called after the AP list is used
+  *    - others: fail, the scan cache is not locked
+  */
+static esp_err_t at_web_scan_cache_acquire(uint32_t max_age_ms, const wifi_ap_record_t **ap_records, uint16_t *number)
+{
+    esp_err_t ret = ESP_OK;
+
+    if (s_scan_cache_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_scan_cache_mutex, portMAX_DELAY);
+    if (s_scan_cache == NULL) {
+        s_scan_cache = (at_web_scan_cache_t *)calloc(1, sizeof(at_web_scan_cache_t));
+        if (s_scan_cache == NULL) {
+            ESP_LOGE(TAG, "scan cache malloc fail");
+            xSemaphoreGive(s_scan_cache_mutex);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    if (s_scan_cache->time_us == 0 || (esp_timer_get_time() - s_scan_cache->time_us) > (int64_t)max_age_ms * 1000) {
+        s_scan_cache->number = ESP_AT_WEB_SCAN_LIST_SIZE;
+        ret = at_web_wifi_scan_get_ap_records(&s_scan_cache->number, s_scan_cache->records);
+        if (ret != ESP_OK) {
+            s_scan_cache->time_us = 0;
+            xSemaphoreGive(s_scan_cache_mutex);
+            return ret;
+        }
+        s_scan_cache->time_us = esp_timer_get_time();
+    } else {
+        ESP_LOGD(TAG, "use the cached %u APs", s_scan_cache->number);
+    }
+
+    *ap_records = s_scan_cache->records;
+    *number = s_scan_cache->number;
+    return ESP_OK;
+}
+
+static void at_web_scan_cache_release(void)
+{
+    xSemaphoreGive(s_scan_cache_mutex);
+}
+
+static void at_web_scan_cache_free(void)
+{
+    if (s_scan_cache_mutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(s_scan_cache_mutex, portMAX_DELAY);
+    free(s_scan_cache);
+    s_scan_cache = NULL;
+    xSemaphoreGive(s_scan_cache_mutex);
+}
+
+static esp_err_t at_web_check_ap_info(const wifi_ap_record_t *ap_info)
 {
     if (ap_info == NULL) {
         return ESP_ERR_INVALID_ARG;
@@ -439,7 +516,8 @@ static esp_err_t at_web_start_scan_filter(uint8_t *phone_mac, uint8_t *password,
     uint64_t end = 0;
     router_obj_t *item = NULL;
     router_obj_t *head_item = NULL;
-    wifi_ap_record_t *ap_info = NULL;
+    const wifi_ap_record_t *ap_info = NULL;
+    uint32_t scan_cache_max_age = CONFIG_AT_WEB_SCAN_CACHE_TIMEOUT * 1000;
     uint8_t highest_rssi_connect_count = 0;
     static uint8_t s_connect_success_flag = 0;
     SLIST_HEAD(router_all_list_head_, router_obj) s_router_all_list = SLIST_HEAD_INITIALIZER(s_router_all_list);
@@ -448,12 +526,6 @@ static esp_err_t at_web_start_scan_filter(uint8_t *phone_mac, uint8_t *password,
         return ESP_ERR_INVALID_ARG;
     }
 
-    ap_info = (wifi_ap_record_t*) malloc(ESP_AT_WEB_SCAN_LIST_SIZE * sizeof(wifi_ap_record_t));
-    if (ap_info == NULL) {
-        ESP_LOGE(TAG, "ap info malloc fail");
-        return ESP_ERR_NO_MEM;
-    }
-
     ESP_LOGD(TAG, "max connect time is %d", max_connect_time);
 
     while (max_try_connect_num > 0) {
@@ -463,10 +535,10 @@ static esp_err_t at_web_start_scan_filter(uint8_t *phone_mac, uint8_t *password,
         }
         // clear the value of the variable
         try_connect_count = 0;
-        ap_scan_number = ESP_AT_WEB_SCAN_LIST_SIZE;
-        memset(ap_info, 0, ESP_AT_WEB_SCAN_LIST_SIZE * sizeof(wifi_ap_record_t));
 
-        ret = at_web_wifi_scan_get_ap_records(&ap_scan_number, ap_info);
+        // the first attempt may use the list just scanned for the web page, the later attempts always scan again
+        ret = at_web_scan_cache_acquire(scan_cache_max_age, &ap_info, &ap_scan_number);
+        scan_cache_max_age = 0;
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "get scan fail");
             goto err;
@@ -498,6 +570,8 @@ static esp_err_t at_web_start_scan_filter(uint8_t *phone_mac, uint8_t *password,
 
             last = item;
         }
+        at_web_scan_cache_release();
+        ap_info = NULL;
 
         if (SLIST_EMPTY(&s_router_all_list)) {
             ESP_LOGE(TAG, "Not find router");
@@ -596,8 +670,6 @@ static esp_err_t at_web_start_scan_filter(uint8_t *phone_mac, uint8_t *password,
 
         if (s_connect_success_flag) {
             s_connect_success_flag = 0;
-            free(ap_info);
-            ap_info = NULL;
             stop_scan_filter();
             ESP_LOGI(TAG, "try connect count is %d", try_connect_count);
             return ESP_OK;
@@ -623,17 +695,11 @@ static esp_err_t at_web_start_scan_filter(uint8_t *phone_mac, uint8_t *password,
             ESP_LOGI(TAG, "current avail time is %d, max_try_connect_num is %d", current_available_time, max_try_connect_num);
         }
     }
-    if (ap_info != NULL) {
-        free(ap_info);
-        ap_info = NULL;
-    }
     // delete fail connect list
     stop_scan_filter();
     ESP_LOGW(TAG, "scan filter timeout");
     return ESP_FAIL;
 err:
-    free(ap_info);
-    ap_info = NULL;
     // delete fail connect list
     stop_scan_filter();
     ESP_LOGW(TAG, "scan filter error");
@@ -691,17 +757,125 @@ static int at_web_find_arg(char *line, char *arg, char *buff, int buffLen)
     return -1; // not found
 }
 
+/* Check whether the If-None-Match header of the request carries the given entity tag */
+static bool at_web_etag_match(httpd_req_t *req, const char *etag)
+{
+    char value[64];
+    esp_err_t err = httpd_req_get_hdr_value_str(req, "If-None-Match", value, sizeof(value));
+    if (err != ESP_OK && err != ESP_ERR_HTTPD_RESULT_TRUNC) {
+        return false;
+    }
+
+    return (strstr(value, etag) != NULL);
+}
+
+static esp_err_t at_web_send_not_modified(httpd_req_t *req)
+{
+    httpd_resp_set_status(req, "304 Not Modified");
+    return httpd_resp_send(req, NULL, 0);
+}
+
 // AT web can use fatfs to storge html or use embeded file to storge html.
 // If use fatfs,we should enable AT FS Command support.
 #ifdef CONFIG_AT_WEB_USE_FATFS
-/* Send HTTP response with the contents of the requested file */
-static esp_err_t web_common_get_handler(httpd_req_t *req)
+#define ESP_AT_WEB_FILE_CACHE_NUM                      4
+
+typedef struct {
+    char *path;                 /*!< the file path of the cached file, NULL if the entry is free */
+    char etag[24];              /*!< the entity tag of the cached file, built from its size and modification time */
+    char *data;                 /*!< the whole content of the cached file */
+    size_t len;                 /*!< the length of the cached file */
+} at_web_file_cache_t;
+
+static at_web_file_cache_t s_web_file_cache[ESP_AT_WEB_FILE_CACHE_NUM];
+static size_t s_web_file_cache_size;
+static uint8_t s_web_file_cache_next;
+
+static void at_web_file_cache_entry_free(at_web_file_cache_t *entry)
+{
+    s_web_file_cache_size -= entry->len;
+    free(entry->path);
+    free(entry->data);
+    memset(entry, 0x0, sizeof(at_web_file_cache_t));
+}
+
+static void at_web_file_cache_clear(void)
+{
+    for (int i = 0; i < ESP_AT_WEB_FILE_CACHE_NUM; i++) {
+        if (s_web_file_cache[i].path) {
+            at_web_file_cache_entry_free(&s_web_file_cache[i]);
+        }
+    }
+    s_web_file_cache_next = 0;
+}
+
+static at_web_file_cache_t *at_web_file_cache_find(const char *filepath)
+{
+    for (int i = 0; i < ESP_AT_WEB_FILE_CACHE_NUM; i++) {
+        if (s_web_file_cache[i].path && strcmp(s_web_file_cache[i].path, filepath) == 0) {
+            return &s_web_file_cache[i];
+        }
+    }
+    return NULL;
+}
+
+/* Read the whole file into the cache, the oldest entries are evicted if the cache is full */
+static at_web_file_cache_t *at_web_file_cache_load(const char *filepath, const char *etag, size_t file_len)
+{
+    at_web_file_cache_t *entry = NULL;
+
+    if (file_len == 0 || file_len > CONFIG_AT_WEB_FILE_CACHE_SIZE) {
+        return NULL;
+    }
+
+    for (int i = 0; i < ESP_AT_WEB_FILE_CACHE_NUM && (s_web_file_cache_size + file_len > CONFIG_AT_WEB_FILE_CACHE_SIZE || entry == NULL); i++) {
+        entry = &s_web_file_cache[s_web_file_cache_next];
+        s_web_file_cache_next = (s_web_file_cache_next + 1) % ESP_AT_WEB_FILE_CACHE_NUM;
+        if (entry->path) {
+            at_web_file_cache_entry_free(entry);
+        }
+    }
+
+    char *data = malloc(file_len);
+    char *path = strdup(filepath);
+    int fd = open(filepath, O_RDONLY);
+    ssize_t read_len = 0;
+    size_t cur_len = 0;
+    if (data == NULL || path == NULL || fd == -1) {
+        goto err;
+    }
+    while (cur_len < file_len) {
+        read_len = read(fd, data + cur_len, file_len - cur_len);
+        if (read_len <= 0) {
+            ESP_LOGE(TAG, "Failed to read file : %s", filepath);
+            goto err;
+        }
+        cur_len += read_len;
+    }
+    close(fd);
+
+    entry->path = path;
+    entry->data = data;
+    entry->len = file_len;
+    strlcpy(entry->etag, etag, sizeof(entry->etag));
+    s_web_file_cache_size += file_len;
+    ESP_LOGD(TAG, "cache file %s, %u bytes", filepath, file_len);
+    return entry;
+
+err:
+    if (fd != -1) {
+        close(fd);
+    }
+    free(path);
+    free(data);
+    return NULL;
+}
+
+/* Stream a file which is too large for the cache */
+static esp_err_t at_web_send_file_chunked(httpd_req_t *req, const char *filepath)
 {
-    char filepath[ESP_AT_WEB_FILE_PATH_MAX];
     esp_err_t err = ESP_FAIL;
     web_server_context_t *s_web_context = (web_server_context_t*) req->user_ctx;
-    strlcpy(filepath, s_web_context->base_path, sizeof(filepath));
-    strlcat(filepath, "/index.html", sizeof(filepath)); // Now, we just send the index html for the common handler
 
     ESP_LOGW(TAG, "open file : %s", filepath);
     int fd = open(filepath, O_RDONLY);
@@ -712,8 +886,6 @@ static esp_err_t web_common_get_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    httpd_resp_set_type(req, "text/html");
-
     char *chunk = s_web_context->scratch;
     ssize_t read_bytes;
     do {
@@ -742,24 +914,99 @@ static esp_err_t web_common_get_handler(httpd_req_t *req)
     httpd_resp_send_chunk(req, NULL, 0);
     return ESP_OK;
 }
+
+/**
+ * @brief Send a file of the web root.
+ * The precompressed <file>.gz is preferred if the client accepts gzip,
+ * the client can revalidate its copy through the entity tag, and the small files are served from RAM.
+ */
+static esp_err_t at_web_send_file(httpd_req_t *req, const char *filepath, const char *type)
+{
+    char path[ESP_AT_WEB_FILE_PATH_MAX + 3];
+    char encoding[64];
+    char etag[24];
+    struct stat st;
+    bool gzip = false;
+    esp_err_t err = httpd_req_get_hdr_value_str(req, "Accept-Encoding", encoding, sizeof(encoding));
+
+    if ((err == ESP_OK || err == ESP_ERR_HTTPD_RESULT_TRUNC) && strstr(encoding, "gzip")) {
+        snprintf(path, sizeof(path), "%s.gz", filepath);
+        gzip = (stat(path, &st) == 0);
+    }
+    if (!gzip) {
+        strlcpy(path, filepath, sizeof(path));
+        if (stat(path, &st) != 0) {
+            ESP_LOGE(TAG, "Failed to stat file : %s, errno =%d", path, errno);
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to read existing file");
+            return ESP_FAIL;
+        }
+    }
+    snprintf(etag, sizeof(etag), "\"%x-%x%s\"", (uint32_t)st.st_size, (uint32_t)st.st_mtime, gzip ? "-gz" : "");
+
+    httpd_resp_set_type(req, type);
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    if (gzip) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    }
+    if (at_web_etag_match(req, etag)) {
+        return at_web_send_not_modified(req);
+    }
+
+    at_web_file_cache_t *entry = at_web_file_cache_find(path);
+    if (entry && strcmp(entry->etag, etag) != 0) {
+        // the file has been changed since it is cached
+        at_web_file_cache_entry_free(entry);
+        entry = NULL;
+    }
+    if (entry == NULL) {
+        entry = at_web_file_cache_load(path, etag, st.st_size);
+    }
+    if (entry) {
+        return httpd_resp_send(req, entry->data, entry->len);
+    }
+
+    return at_web_send_file_chunked(req, path);
+}
+
+/* Send HTTP response with the contents of the requested file */
+static esp_err_t web_common_get_handler(httpd_req_t *req)
+{
+    char filepath[ESP_AT_WEB_FILE_PATH_MAX];
+    web_server_context_t *s_web_context = (web_server_context_t*) req->user_ctx;
+    strlcpy(filepath, s_web_context->base_path, sizeof(filepath));
+    strlcat(filepath, "/index.html", sizeof(filepath)); // Now, we just send the index html for the common handler
+
+    return at_web_send_file(req, filepath, "text/html");
+}
 #else
 static esp_err_t index_html_get_handler(httpd_req_t *req)
 {
     extern const char html_start[] asm("_binary_index_html_start");
     extern const char html_end[]   asm("_binary_index_html_end");
     const size_t html_size = (html_end - html_start);
+    static char s_index_html_etag[12];
+
+    // the embedded html never changes in one firmware, so its crc is a stable entity tag
+    if (s_index_html_etag[0] == '\0') {
+        snprintf(s_index_html_etag, sizeof(s_index_html_etag), "\"%08x\"", esp_rom_crc32_le(0, (const uint8_t *)html_start, html_size));
+    }
     httpd_resp_set_type(req, "text/html");
-    /* Add file upload form and script which on execution sends a POST request to /upload */
-    httpd_resp_send_chunk(req, (const char*) html_start, html_size);
-    /* Respond with an empty chunk to signal HTTP response completion */
-    return httpd_resp_send_chunk(req, NULL, 0);
+    httpd_resp_set_hdr(req, "ETag", s_index_html_etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    if (at_web_etag_match(req, s_index_html_etag)) {
+        return at_web_send_not_modified(req);
+    }
+
+    /* The html is already mapped into the address space, send it in one response with the content length */
+    return httpd_resp_send(req, (const char*) html_start, html_size);
 }
 
 /* Send HTTP response with the contents of the requested file */
 static esp_err_t web_common_get_handler(httpd_req_t *req)
 {
     return index_html_get_handler(req);
-    return ESP_OK;
 }
 #endif
 
@@ -1404,65 +1651,74 @@ error_handle:
     return ESP_FAIL;
 }
 
+static int at_web_ap_record_to_json(char *buf, const wifi_ap_record_t *ap_info, bool first)
+{
+    int json_len = 0;
+    int32_t ssid_len = strlen((const char*)ap_info->ssid);
+
+    json_len += sprintf(buf + json_len, "%s{\"ssid\":\"", first ? "" : ",");
+    for (int i = 0; i < ssid_len; i++) {
+        uint8_t c = ap_info->ssid[i];
+        // escape special non-control characters in json format, see https://www.json.org/json-en.html for more details
+        if (c == '\\' || c == '\"' || c == '/') {
+            buf[json_len++] = '\\';
+        }
+        buf[json_len++] = c;
+    }
+    json_len += sprintf(buf + json_len, "\",\"auth_mode\":%d}", ap_info->authmode);
+
+    return json_len;
+}
+
 static esp_err_t ap_record_get_handler(httpd_req_t *req)
 {
-    uint16_t ap_number = ESP_AT_WEB_AP_SCAN_NUM_DEFAULT;
+    const wifi_ap_record_t *ap_info = NULL;
+    uint16_t ap_number = 0;
     int loop = 0;
     int32_t json_len = 0;
-    int valid_ap_count = 1;
-    char *temp_json_str = NULL;
-    wifi_ap_record_t *ap_info = (wifi_ap_record_t*) malloc(ESP_AT_WEB_AP_SCAN_NUM_DEFAULT * sizeof(wifi_ap_record_t));
-    if (ap_info == NULL) {
-        ESP_LOGE(TAG, "ap info malloc fail");
-        return ESP_FAIL;
-    }
-    memset(ap_info, 0, ESP_AT_WEB_AP_SCAN_NUM_DEFAULT * sizeof(wifi_ap_record_t));
+    int valid_ap_count = 0;
+    char *buf = ((web_server_context_t*)(req->user_ctx))->scratch;
+    esp_err_t ret = ESP_OK;
 
-    if (at_web_wifi_scan_get_ap_records(&ap_number, ap_info) != ESP_OK) {
+    if (at_web_scan_cache_acquire(CONFIG_AT_WEB_SCAN_CACHE_TIMEOUT * 1000, &ap_info, &ap_number) != ESP_OK) {
         at_web_response_error(req, HTTPD_500);
-        goto error_handle;
-    }
-
-    temp_json_str = (char*) malloc(ESP_AT_WEB_AP_RECORD_JSON_STR_LEN * sizeof(char));
-    if (temp_json_str == NULL) {
-        ESP_LOGE(TAG, "temp_json_str malloc fail");
-        goto error_handle;
+        return ESP_FAIL;
     }
-    memset(temp_json_str, 0, ESP_AT_WEB_AP_RECORD_JSON_STR_LEN * sizeof(char));
 
+    // stream the json array through the scratch buffer, which is sent once it cannot hold one more AP record
     httpd_resp_set_type(req, "application/json");
-    json_len += sprintf(temp_json_str + json_len, "{\"state\":0,\"message\":\"scan done\",\"aplist\":["); // to get a json array format str
-
-    for (loop = 0; loop < ap_number; loop++) {
-        int32_t ssid_len = strlen((const char*)ap_info[loop].ssid);
-        if (ssid_len != 0) { // ingore hidden ssid
-            json_len += sprintf(temp_json_str + json_len, "{\"ssid\":\"");
-            for (int i = 0; i < ssid_len; i++) {
-                uint8_t c = ap_info[loop].ssid[i];
-                // escape special non-control characters in json format, see https://www.json.org/json-en.html for more details
-                if (c == '\\' || c == '\"' || c == '/') {
-                    json_len += sprintf(temp_json_str + json_len, "\\");
-                }
-                json_len += sprintf(temp_json_str + json_len, "%c", c);
-            }
-            json_len += sprintf(temp_json_str + json_len, "\",\"auth_mode\":%d},", ap_info[loop].authmode);
+    json_len += sprintf(buf + json_len, "{\"state\":0,\"message\":\"scan done\",\"aplist\":[");
 
-            valid_ap_count++;
+    for (loop = 0; (loop < ap_number) && (valid_ap_count < ESP_AT_WEB_AP_SCAN_NUM_DEFAULT); loop++) {
+        if (strlen((const char*)ap_info[loop].ssid) == 0) { // ingore hidden ssid
+            continue;
         }
+        if (json_len + ESP_AT_WEB_AP_RECORD_JSON_MAX_LEN > ESP_AT_WEB_SCRATCH_BUFSIZE) {
+            ret = httpd_resp_send_chunk(req, buf, json_len);
+            json_len = 0;
+            if (ret != ESP_OK) {
+                break;
+            }
+        }
+        json_len += at_web_ap_record_to_json(buf + json_len, &ap_info[loop], valid_ap_count == 0);
+        valid_ap_count++;
     }
-    free(ap_info);
+    at_web_scan_cache_release();
     ap_info = NULL;
 
-    json_len += sprintf(temp_json_str + json_len - 1, "]}");
-    ESP_LOGD(TAG, "now, valid ap num is %d, ap records json str is %s\n", valid_ap_count, temp_json_str);
-    httpd_resp_send(req, temp_json_str, (temp_json_str == NULL) ? 0 : strlen(temp_json_str));
-    free(temp_json_str);
-    temp_json_str = NULL;
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "ap records sending failed, err: %d", ret);
+        /* Abort sending ap records */
+        httpd_resp_sendstr_chunk(req, NULL);
+        return ESP_FAIL;
+    }
+
+    json_len += sprintf(buf + json_len, "]}");
+    ESP_LOGD(TAG, "now, valid ap num is %d", valid_ap_count);
+    httpd_resp_send_chunk(req, buf, json_len);
+    /* Respond with an empty chunk to signal HTTP response completion */
+    httpd_resp_send_chunk(req, NULL, 0);
     return ESP_OK;
-error_handle:
-    free(ap_info);
-    ap_info = NULL;
-    return ESP_FAIL;
 }
 
 const esp_partition_t *at_web_get_ota_update_partition(void)
@@ -1514,12 +1770,49 @@ esp_err_t at_web_ota_end(esp_ota_handle_t handle, const esp_partition_t *partiti
     return err;
 }
 
+static int at_web_upload_recv(httpd_req_t *req, char *buf, int len)
+{
+    int received_len = 0;
+    int ret = 0;
+
+    // fill up the upload buffer, so that the flash is written in large pieces
+    while (received_len < len) {
+        ret = httpd_req_recv(req, buf + received_len, len - received_len);
+        if (ret <= 0) {
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+                /* Retry if timeout occurred */
+                continue;
+            }
+            return ret;
+        }
+        received_len += ret;
+    }
+
+    return received_len;
+}
+
+static void at_web_response_upload_ok(httpd_req_t *req, int total_len, int64_t cost_us)
+{
+    char resp[96];
+    // one byte per microsecond is 1 MB/s, keep two decimal places without the float format
+    uint32_t speed = (cost_us > 0) ? (uint32_t)((uint64_t)total_len * 100 / cost_us) : 0;
+    int len = snprintf(resp, sizeof(resp), "{\"state\": 0, \"size\": %d, \"time_ms\": %u, \"speed\": \"%u.%02u MB/s\"}",
+                       total_len, (uint32_t)(cost_us / 1000), speed / 100, speed % 100);
+
+    ESP_LOGI(TAG, "upload %d bytes in %u ms, %u.%02u MB/s", total_len, (uint32_t)(cost_us / 1000), speed / 100, speed % 100);
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    httpd_resp_set_status(req, HTTPD_200);
+
+    httpd_resp_send(req, resp, len);
+}
+
 static esp_err_t ota_upgrade(httpd_req_t *req)
 {
-    char *buf = ((web_server_context_t*)(req->user_ctx))->scratch;
+    char *buf = NULL;
     int total_len = req->content_len;
     int remaining_len = req->content_len;
     int received_len = 0;
+    int64_t start_us = esp_timer_get_time();
     esp_err_t err = ESP_FAIL;
 #if defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED) && defined(CONFIG_ENABLE_LEGACY_ESP_BOOTLOADER_PLUS_V2_SUPPORT)
     at_compress_ota_handle_t handle;
@@ -1533,7 +1826,13 @@ static esp_err_t ota_upgrade(httpd_req_t *req)
         goto err_handler;
     }
     ESP_LOGI(TAG, "bin size is %d", total_len);
-    memset(buf, 0x0, ESP_AT_WEB_SCRATCH_BUFSIZE * sizeof(char));
+
+    // the upload buffer only lives as long as the upload
+    buf = malloc(CONFIG_AT_WEB_UPLOAD_BUFFER_SIZE);
+    if (buf == NULL) {
+        ESP_LOGE(TAG, "upload buffer alloc fail");
+        goto err_handler;
+    }
 
     // start ota
 #if defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED) && defined(CONFIG_ENABLE_LEGACY_ESP_BOOTLOADER_PLUS_V2_SUPPORT)
@@ -1547,12 +1846,8 @@ static esp_err_t ota_upgrade(httpd_req_t *req)
     }
     // receive ota data
     while (remaining_len > 0) {
-        received_len = httpd_req_recv(req, buf, MIN(remaining_len, ESP_AT_WEB_SCRATCH_BUFSIZE)); // Receive the file part by part into a buffer
+        received_len = at_web_upload_recv(req, buf, MIN(remaining_len, CONFIG_AT_WEB_UPLOAD_BUFFER_SIZE)); // Receive the file part by part into a buffer
         if (received_len <= 0) { // received error
-            if (received_len == HTTPD_SOCK_ERR_TIMEOUT) {
-                /* Retry if timeout occurred */
-                continue;
-            }
             ESP_LOGE(TAG, "Failed to receive post ota data, err = %d", received_len);
 #if defined(CONFIG_BOOTLOADER_COMPRESSED_ENABLED) && defined(CONFIG_ENABLE_LEGACY_ESP_BOOTLOADER_PLUS_V2_SUPPORT)
             at_compress_ota_end(&handle);
@@ -1586,12 +1881,14 @@ static esp_err_t ota_upgrade(httpd_req_t *req)
     if (err != ESP_OK) {
         goto err_handler;
     }
-    at_web_response_ok(req);
+    free(buf);
+    at_web_response_upload_ok(req, total_len, esp_timer_get_time() - start_us);
     esp_at_port_active_write_data((uint8_t*)s_ota_receive_success_response, strlen(s_ota_receive_success_response));
     ESP_LOGI(TAG, "ota end successfully, please restart");
     return ESP_OK;
 
 err_handler:
+    free(buf);
     at_web_response_error(req, HTTPD_500);
     esp_at_port_active_write_data((uint8_t*)s_ota_receive_fail_response, strlen(s_ota_receive_fail_response));
     return ESP_FAIL;
@@ -1625,12 +1922,8 @@ static esp_err_t partition_upgrade(httpd_req_t *req, char *buf, const int total_
     }
 
     for (;;) {
-        single_received_len = httpd_req_recv(req, buf, MIN(remaining_len, ESP_AT_WEB_SCRATCH_BUFSIZE));
+        single_received_len = at_web_upload_recv(req, buf, MIN(remaining_len, CONFIG_AT_WEB_UPLOAD_BUFFER_SIZE));
         if (single_received_len <= 0) {
-            if (single_received_len == HTTPD_SOCK_ERR_TIMEOUT) {
-                /* Retry if timeout occurred */
-                continue;
-            }
             ESP_LOGE(TAG, "Failed to receive post ota data, err = %d", single_received_len);
             return ESP_FAIL;
         } else {
@@ -1654,12 +1947,15 @@ static esp_err_t partition_upgrade(httpd_req_t *req, char *buf, const int total_
 static esp_err_t at_customize_partition_upgrade(httpd_req_t *req, const char* partition_name)
 {
     esp_err_t err = ESP_OK;
-    char *buf = ((web_server_context_t*)(req->user_ctx))->scratch;
     int total_len = req->content_len;
+    int64_t start_us = esp_timer_get_time();
 
+    // the upload buffer only lives as long as the upload
+    char *buf = malloc(CONFIG_AT_WEB_UPLOAD_BUFFER_SIZE);
     err = partition_upgrade(req, buf, total_len, partition_name);
+    free(buf);
     if (err == ESP_OK) {
-        at_web_response_ok(req);
+        at_web_response_upload_ok(req, total_len, esp_timer_get_time() - start_us);
         esp_at_port_active_write_data((uint8_t*)s_ota_receive_success_response, strlen(s_ota_receive_success_response));
         return ESP_OK;
     } else {
@@ -1788,6 +2084,11 @@ static esp_err_t start_web_server(const char *base_path, uint16_t server_port)
     s_web_context = calloc(1, sizeof(web_server_context_t));
     ESP_AT_WEB_SERVER_CHECK(s_web_context, "No memory for rest context", err);
     strlcpy(s_web_context->base_path, base_path, sizeof(s_web_context->base_path));
+    if (s_scan_cache_mutex == NULL) {
+        // the mutex is kept after the server stops, the scan filter may still be running
+        s_scan_cache_mutex = xSemaphoreCreateMutex();
+        ESP_AT_WEB_SERVER_CHECK(s_scan_cache_mutex, "No memory for scan cache mutex", err_start);
+    }
 
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.max_uri_handlers = 8;
@@ -1844,6 +2145,10 @@ static esp_err_t stop_web_server(void)
     free(s_web_context);
     s_web_context = NULL;
     s_server = NULL;
+    at_web_scan_cache_free();
+#ifdef CONFIG_AT_WEB_USE_FATFS
+    at_web_file_cache_clear();
+#endif
     ESP_LOGI(TAG, "Stop HTTP Server");
 #ifdef CONFIG_AT_WEB_CAPTIVE_PORTAL_ENABLE
     if (s_at_web_redirect_url) {
@@ -1886,11 +2191,29 @@ static esp_err_t at_web_fatfs_spiflash_deinit(void)
 }
 #endif
 
+static void at_web_got_ip_cb(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    at_web_update_sta_got_ip_flag(true);
+}
+
+/* The got-ip event is only watched once the web server is used, rather than from the command set registration at boot */
+static void at_web_cmd_set_lazy_init(void)
+{
+    static bool s_web_cmd_set_inited = false;
+
+    if (!s_web_cmd_set_inited) {
+        if (esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &at_web_got_ip_cb, NULL, NULL) == ESP_OK) {
+            s_web_cmd_set_inited = true;
+        }
+    }
+}
+
 static esp_err_t at_web_start(uint16_t server_port)
 {
     esp_err_t err;
 
     if (s_server == NULL) {
+        at_web_cmd_set_lazy_init();
         /*AT web can use fatfs to storge html or use embeded file to storge html.If use fatfs, we should enable AT FS Command support*/
 #ifdef CONFIG_AT_WEB_USE_FATFS
         err = at_web_fatfs_spiflash_init();
@@ -1995,14 +2318,8 @@ static const esp_at_cmd_struct at_web_cmd[] = {
     {"+WEBSERVER", NULL, NULL,  at_setupCmdWebConf, NULL},
 };
 
-static void at_web_got_ip_cb(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
-{
-    at_web_update_sta_got_ip_flag(true);
-}
-
 bool esp_at_web_server_cmd_regist(void)
 {
-    esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &at_web_got_ip_cb, NULL, NULL);
     return esp_at_custom_cmd_array_regist(at_web_cmd, sizeof(at_web_cmd) / sizeof(at_web_cmd[0]));
 }
 
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "esp_http_client.h"
+#include "esp_at_interface.h"
 
 #define AT_NETWORK_TIMEOUT_MS       (5000)
 
@@ -189,14 +190,14 @@ static uint8_t at_setup_cmd_httpget_from_ram(uint8_t para_num)
     char header[64];
     int headerLen = snprintf(header, sizeof(header), "+HTTPGET_FROM_RAM:%" PRId32 ",", length);
 
-    // Send chunk
-    if(esp_at_port_write_data((uint8_t *) header, headerLen) != headerLen)
-        return ESP_AT_RESULT_CODE_ERROR;
-
-    if(esp_at_port_write_data(file_store.buffer + offset, length) != length)
-        return ESP_AT_RESULT_CODE_ERROR;
-
-    if(esp_at_port_write_data((uint8_t *) "\r\n", 2) != 2)
+    // Send chunk: the header, the data and the trailer as one transaction, without copying the data
+    esp_at_iovec_t iov[] =
+    {
+        { (uint8_t *) header, headerLen },
+        { file_store.buffer + offset, length },
+        { (uint8_t *) "\r\n", 2 },
+    };
+    if(esp_at_port_writev(iov, sizeof(iov) / sizeof(iov[0])) != headerLen + length + 2)
         return ESP_AT_RESULT_CODE_ERROR;
 
     return ESP_AT_RESULT_CODE_OK;
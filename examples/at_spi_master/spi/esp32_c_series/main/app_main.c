@@ -45,7 +45,8 @@ Pins in use. The SPI Master can use the GPIO mux, so feel free to change these i
 #endif
 
 #define DMA_CHAN              SPI_DMA_CH_AUTO
-#define ESP_SPI_DMA_MAX_LEN   4092
+#define ESP_SPI_DMA_MAX_LEN   CONFIG_SPI_DMA_MAX_LEN
+#define ESP_SPI_DMA_LEGACY_LEN 4092        // the transaction length of the slave which does not publish its maximum length
 #define CMD_HD_WRBUF_REG      0x01
 #define CMD_HD_RDBUF_REG      0x02
 #define CMD_HD_WRDMA_REG      0x03
@@ -54,6 +55,8 @@ Pins in use. The SPI Master can use the GPIO mux, so feel free to change these i
 #define CMD_HD_INT0_REG       0x08
 #define WRBUF_START_ADDR      0x0
 #define RDBUF_START_ADDR      0x4
+#define NEGO_START_ADDR       0xC
+#define NEGO_MAGIC            0xFD
 #define STREAM_BUFFER_SIZE    1024 * 8
 
 typedef enum {
@@ -76,8 +79,17 @@ typedef struct {
     uint32_t     direct : 8;
     uint32_t     seq_num : 8;
     uint32_t     transmit_len : 16;
+    uint32_t     max_trans_len : 16;    // the maximum length slave can receive in one transaction, 0 from the legacy slave
+    uint32_t     nego_req : 1;          // 1: slave (re)started and has not received the master's maximum length, 0 from the legacy slave
+    uint32_t     reserved : 15;
 } spi_recv_opt_t;
 
+typedef struct {
+    uint32_t     magic : 8;             // 0xFD
+    uint32_t     reserved : 8;
+    uint32_t     max_trans_len : 16;    // the maximum length master can receive in one transaction
+} spi_nego_opt_t;
+
 typedef struct {
     spi_mode_t direct;
 } spi_msg_t;
@@ -90,9 +102,12 @@ static const char* TAG = "SPI AT Master";
 static SemaphoreHandle_t pxMutex;
 static uint8_t initiative_send_flag = 0; // it means master has data to send to slave
 static uint32_t plan_send_len = 0; // master plan to send data len
+static uint32_t max_send_len = ESP_SPI_DMA_LEGACY_LEN; // negotiated length of one master -> slave transaction
 
 static uint8_t current_send_seq = 0;
 static uint8_t current_recv_seq = 0;
+static bool nego_announced = false; // the maximum length is announced, and slave has not handled it yet
+static bool nego_just_announced = false; // the maximum length is announced by the latest status query
 
 static void spi_mutex_lock(void)
 {
@@ -178,21 +193,65 @@ static void at_spi_wrdma_done(void)
     spi_device_polling_transmit(handle, &end_t);
 }
 
+// tell slave the maximum length master can receive in one transaction, so that slave can send the larger bursts.
+// the legacy slave ignores it.
+static void spi_master_announce_max_trans_len(void)
+{
+    spi_nego_opt_t nego_opt = {
+        .magic = NEGO_MAGIC,
+        .max_trans_len = ESP_SPI_DMA_MAX_LEN,
+    };
+
+    spi_transaction_t trans = {
+        .cmd = CMD_HD_WRBUF_REG,
+        .addr = NEGO_START_ADDR,
+        .length = sizeof(spi_nego_opt_t) * 8,
+        .tx_buffer = &nego_opt,
+    };
+    spi_device_polling_transmit(handle, (spi_transaction_t*)&trans);
+    nego_announced = true;
+}
+
 // when spi slave ready to send/recv data from the spi master, the spi slave will a trigger GPIO interrupt,
 // then spi master should query whether the slave will perform read or write operation.
 static spi_recv_opt_t query_slave_data_trans_info()
 {
-    spi_recv_opt_t recv_opt;
+    spi_recv_opt_t recv_opt = {0};
     spi_transaction_t trans = {
         .cmd = CMD_HD_RDBUF_REG,
         .addr = RDBUF_START_ADDR,
-        .rxlength = 4 * 8,
+        .rxlength = sizeof(spi_recv_opt_t) * 8,
         .rx_buffer = &recv_opt,
     };
     spi_device_polling_transmit(handle, (spi_transaction_t*)&trans);
+
+    // the slave publishes the maximum length it can receive in one transaction
+    if (recv_opt.max_trans_len > 0) {
+        max_send_len = recv_opt.max_trans_len < ESP_SPI_DMA_MAX_LEN ? recv_opt.max_trans_len : ESP_SPI_DMA_MAX_LEN;
+    } else {
+        max_send_len = ESP_SPI_DMA_LEGACY_LEN;
+    }
+
+    // the slave requests the announcement again after it restarts, announce it only once to avoid
+    // the redundant buffer writes being handled as write requests
+    nego_just_announced = false;
+    if (!recv_opt.nego_req) {
+        nego_announced = false;
+    } else if (!nego_announced) {
+        spi_master_announce_max_trans_len();
+        nego_just_announced = true;
+    }
     return recv_opt;
 }
 
+// the sequence numbers restart with the slave, the announcement which slave had not handled before it restarted is lost
+static void spi_master_slave_restarted(const spi_recv_opt_t* recv_opt)
+{
+    if (recv_opt->nego_req && !nego_just_announced) {
+        spi_master_announce_max_trans_len();
+    }
+}
+
 // before spi master write to slave, the master should write WRBUF_REG register to notify slave,
 // and then wait for handshark line trigger gpio interrupt to start the data transmission.
 static void spi_master_request_to_write(uint8_t send_seq, uint16_t send_len)
@@ -216,7 +275,7 @@ static void spi_master_request_to_write(uint8_t send_seq, uint16_t send_len)
 // spi master write data to slave
 static int8_t spi_write_data(uint8_t* buf, int32_t len)
 {
-    if (len > ESP_SPI_DMA_MAX_LEN) {
+    if (len > max_send_len) {
         ESP_LOGE(TAG, "Send length errot, len:%ld", len);
         return -1;
     }
@@ -246,7 +305,7 @@ static void notify_slave_to_recv(void)
         spi_mutex_lock();
         uint32_t tmp_send_len = xStreamBufferBytesAvailable(spi_master_tx_ring_buf);
         if (tmp_send_len > 0) {
-            plan_send_len = tmp_send_len > ESP_SPI_DMA_MAX_LEN ? ESP_SPI_DMA_MAX_LEN : tmp_send_len;
+            plan_send_len = tmp_send_len > max_send_len ? max_send_len : tmp_send_len;
             spi_master_request_to_write(current_send_seq + 1, plan_send_len); // to tell slave that the master want to write data
             initiative_send_flag = 1;
         }
@@ -260,7 +319,7 @@ static void IRAM_ATTR spi_trans_control_task(void* arg)
     spi_master_msg_t trans_msg = {0};
     uint32_t send_len = 0;
 
-    uint8_t* trans_data = (uint8_t*)malloc(ESP_SPI_DMA_MAX_LEN * sizeof(uint8_t));
+    uint8_t* trans_data = (uint8_t*)malloc((ESP_SPI_DMA_MAX_LEN + 1) * sizeof(uint8_t));
     if (trans_data == NULL) {
         ESP_LOGE(TAG, "malloc fail");
         return;
@@ -281,6 +340,7 @@ static void IRAM_ATTR spi_trans_control_task(void* arg)
                 ESP_LOGE(TAG, "SPI send seq error, %x, %x", recv_opt.seq_num, current_send_seq);
                 if (recv_opt.seq_num == 1) {
                     ESP_LOGE(TAG, "Maybe SLAVE restart, ignore");
+                    spi_master_slave_restarted(&recv_opt);
                     current_send_seq = recv_opt.seq_num;
                 } else {
                     break;
@@ -304,7 +364,7 @@ static void IRAM_ATTR spi_trans_control_task(void* arg)
             // maybe streambuffer filled some data when SPI transimit, just consider it after send done, because send flag has already in SLAVE queue
             uint32_t tmp_send_len = xStreamBufferBytesAvailable(spi_master_tx_ring_buf);
             if (tmp_send_len > 0) {
-                plan_send_len = tmp_send_len > ESP_SPI_DMA_MAX_LEN ? ESP_SPI_DMA_MAX_LEN : tmp_send_len;
+                plan_send_len = tmp_send_len > max_send_len ? max_send_len : tmp_send_len;
                 spi_master_request_to_write(current_send_seq + 1, plan_send_len);
             } else {
                 initiative_send_flag = 0;
@@ -315,12 +375,13 @@ static void IRAM_ATTR spi_trans_control_task(void* arg)
                 ESP_LOGE(TAG, "SPI recv seq error, %x, %x", recv_opt.seq_num, (current_recv_seq + 1));
                 if (recv_opt.seq_num == 1) {
                     ESP_LOGE(TAG, "Maybe SLAVE restart, ignore");
+                    spi_master_slave_restarted(&recv_opt);
                 } else {
                     break;
                 }
             }
 
-            if (recv_opt.transmit_len > STREAM_BUFFER_SIZE || recv_opt.transmit_len == 0) {
+            if (recv_opt.transmit_len > ESP_SPI_DMA_MAX_LEN || recv_opt.transmit_len == 0) {
                 ESP_LOGE(TAG, "SPI read len error, %x", recv_opt.transmit_len);
                 break;
             }
@@ -457,6 +518,7 @@ static void init_master_hd(spi_device_handle_t* spi)
             ESP_LOGE(TAG, "SPI recv seq error, %x, %x", recv_opt.seq_num, (current_recv_seq + 1));
             if (recv_opt.seq_num == 1) {
                 ESP_LOGE(TAG, "Maybe SLAVE restart, ignore");
+                spi_master_slave_restarted(&recv_opt);
             }
         }
 
@@ -464,6 +526,10 @@ static void init_master_hd(spi_device_handle_t* spi)
 
         at_spi_rddma_done();
     }
+
+    if (!nego_announced) {
+        spi_master_announce_max_trans_len();
+    }
     spi_mutex_unlock();
 }
 
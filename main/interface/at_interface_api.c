@@ -85,6 +85,57 @@ static int32_t at_port_write_data(uint8_t *data, int32_t len)
     return write_fn(data, len);
 }
 
+int32_t esp_at_port_writev(const esp_at_iovec_t *iov, int32_t iovcnt)
+{
+    if (!iov || iovcnt <= 0) {
+        return -1;
+    }
+
+    at_writev_data_fn_t writev_fn = s_interface_ops.writev_data;
+
+    // the security channel and the self-command mode only know the segment-based write
+#ifdef CONFIG_AT_INTF_SECURITY_SUPPORT
+    if (s_intf_security_ops.write) {
+        writev_fn = NULL;
+    }
+#endif
+
+#ifdef CONFIG_AT_SELF_COMMAND_SUPPORT
+    if (unlikely(at_self_cmd_get_mode())) {
+        writev_fn = NULL;
+    }
+#endif
+
+    if (!writev_fn) {
+        // fallback: write the segments one by one, through the same interface layer as the vectored write
+        int32_t had_written_len = 0;
+        for (int32_t i = 0; i < iovcnt; ++i) {
+            if (iov[i].len <= 0) {
+                continue;
+            }
+            int32_t ret = at_port_write_data((uint8_t *)iov[i].data, iov[i].len);
+            if (ret < 0) {
+                return had_written_len ? had_written_len : ret;
+            }
+            had_written_len += ret;
+            if (ret != iov[i].len) {
+                break;
+            }
+        }
+        return had_written_len;
+    }
+
+#if CONFIG_AT_TX_DATA_DEBUG
+    for (int32_t i = 0; i < iovcnt; ++i) {
+        if (iov[i].len > 0) {
+            ESP_AT_LOG_BUFFER_HEXDUMP("intf-tx", iov[i].data, at_min(iov[i].len, CONFIG_AT_TX_DATA_MAX_LEN), ESP_LOG_INFO);
+        }
+    }
+#endif
+
+    return writev_fn(iov, iovcnt);
+}
+
 static int32_t at_port_get_data_len(void)
 {
     if (!s_interface_ops.get_data_length) {
@@ -126,6 +177,7 @@ void at_interface_ops_init(esp_at_device_ops_struct *ops)
     s_interface_ops.write_data = ops->write_data;
     s_interface_ops.get_data_length = ops->get_data_length;
     s_interface_ops.wait_write_complete = ops->wait_write_complete;
+    s_interface_ops.writev_data = ops->writev_data;
 
     esp_at_device_ops_struct at_port_ops = {
         .read_data = at_port_read_data,
@@ -202,6 +254,11 @@ static void at_normal_wakeup_before_cb(void)
 
 static void at_deep_sleep_before_cb(void)
 {
+#ifdef CONFIG_AT_NVS_WRITE_BACK_CACHE
+    // the cached AT configurations are lost in deep sleep
+    esp_at_nvs_flush();
+#endif
+
     // do some special things from the interface hook before deep sleep
     if (s_interface_hooks.pre_deepsleep_callback) {
         s_interface_hooks.pre_deepsleep_callback();
@@ -212,6 +269,9 @@ static void at_restart_before_cb(void)
 {
     // do some common things before restart
     at_port_wait_tx_done(ESP_AT_PORT_TX_WAIT_MS_MAX);
+#ifdef CONFIG_AT_NVS_WRITE_BACK_CACHE
+    esp_at_nvs_flush();
+#endif
 
     // do some special things from the interface hook before restart
     if (s_interface_hooks.pre_restart_callback) {
@@ -0,0 +1,29 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#ifdef CONFIG_AT_BASE_ON_SPI
+
+/**
+ * @brief The spi transfer statistics since boot
+*/
+typedef struct {
+    uint32_t rx_bytes;      /**< bytes received from the master, wraps around at 4 GB */
+    uint32_t tx_bytes;      /**< bytes sent to the master, wraps around at 4 GB */
+    uint32_t rx_trans;      /**< spi transactions of master -> slave */
+    uint32_t tx_trans;      /**< spi transactions of slave -> master */
+} at_spi_stats_t;
+
+/**
+ * @brief This function is used to get the spi transfer statistics.
+ *
+ * @param[out] stats: The pointer of at_spi_stats_t
+*/
+void at_spi_stats_get(at_spi_stats_t *stats);
+
+#endif
@@ -33,6 +33,10 @@
 #define AT_UART_BAUD_RATE_MIN                       80                      /**< minimum uart baud rate */
 #define AT_UART_BAUD_RATE_DEF                       115200                  /**< default uart baud rate */
 #define AT_UART_PATTERN_TIMEOUT_MS                  20                      /**< uart pattern timeout */
+#define AT_UART_RXFIFO_FULL_THRESH_DEF              100                     /**< default uart rx fifo full threshold */
+#define AT_UART_RX_TIMEOUT_THRESH_DEF               10                      /**< default uart rx timeout threshold, unit: the time of one byte */
+#define AT_UART_RX_WINDOW_MS_MAX                    1000                    /**< maximum rx coalescing time window */
+#define AT_UART_DISCARD_BUFFER_SIZE                 128                     /**< the static scratch buffer size to drop the received data */
 
 #define AT_UART_PARITY_NONE                         UART_PARITY_DISABLE     /**< uart parity disable */
 #define AT_UART_PARITY_EVEN                         UART_PARITY_EVEN        /**< uart parity even */
@@ -118,6 +122,24 @@ typedef struct {
     int8_t flow_control;    /**< uart flow control */
 } at_uart_config_t;
 
+/**
+ * @brief The uart rx notification configuration, which trades latency for throughput
+*/
+typedef struct {
+    uint8_t rxfifo_full_thresh;     /**< uart rx fifo full threshold */
+    uint8_t rx_timeout_thresh;      /**< uart rx timeout threshold, unit: the time of one byte */
+    uint16_t window_ms;             /**< rx coalescing time window, 0: notify the AT core as soon as the rx events are drained */
+    uint32_t window_bytes;          /**< rx coalescing byte window, notify the AT core once so many bytes are buffered, 0: no limit */
+} at_uart_rx_config_t;
+
+/**
+ * @brief The uart rx statistics
+*/
+typedef struct {
+    uint32_t heap_alloc_num;        /**< the number of heap allocations in the uart rx path, only counted if CONFIG_AT_UART_HEAP_ALLOC_COUNTER is enabled */
+    uint32_t discard_bytes;         /**< the bytes dropped by the read operation without a buffer and by the "+++" exit handling */
+} at_uart_rx_stats_t;
+
 /**
  * @brief The uart port and pins configuration
 */
@@ -215,8 +237,41 @@ void at_uart_workaround(void);
 void at_uart_config_init(uart_config_t *config);
 
 /**
- * @brief Configure uart interrupt.
+ * @brief Configure uart interrupt with the thresholds of current rx notification configuration.
+ *
+ * @return
+ *    - ESP_OK: succeed
+ *    - others: fail
+*/
+esp_err_t at_uart_intr_config(void);
+
+/**
+ * @brief Get the uart rx notification configuration.
+ *
+ * @param[out] config: The pointer of at_uart_rx_config_t
+*/
+void at_uart_rx_config_get(at_uart_rx_config_t *config);
+
+/**
+ * @brief Set the uart rx notification configuration, and apply the thresholds to the uart interrupt.
+ *
+ * The rx events are coalesced into one notification to the AT core while the data keeps streaming in,
+ * until the time window expires or the byte window is reached. An rx event which is shorter than the
+ * rx fifo full threshold means the line is idle, and the AT core is notified immediately.
+ *
+ * @param[in] config: The pointer of at_uart_rx_config_t
+ *
+ * @return
+ *    - ESP_OK: succeed
+ *    - others: fail
+*/
+esp_err_t at_uart_rx_config_set(const at_uart_rx_config_t *config);
+
+/**
+ * @brief Get the uart rx statistics since the interface is initialized.
+ *
+ * @param[out] stats: The pointer of at_uart_rx_stats_t
 */
-void at_uart_intr_config(void);
+void at_uart_rx_stats_get(at_uart_rx_stats_t *stats);
 
 #endif
@@ -10,6 +10,10 @@
 #include "at_uart.h"
 #endif
 
+#ifdef CONFIG_AT_BASE_ON_SPI
+#include "at_spi.h"
+#endif
+
 /**
  * @brief This function is used to initialize at interface.
  *
@@ -29,12 +33,30 @@ void at_interface_start(void);
  * @brief This function is used to intialize the interface operations for communication port.
  *
  * @note Each interface must have its own operations, you can use the default operations or customize your own operations.
- * @note The interface operations include: read data, write data, get data length, wait data tx done.
+ * @note The interface operations include: read data, write data, get data length, wait data tx done, and the optional vectored write.
  *
  * @param[in] ops: The pointer of the interface operations.
 */
 void at_interface_ops_init(esp_at_device_ops_struct *ops);
 
+/**
+ * @brief This function is used to write several data segments into the communication port as one transaction.
+ *
+ * @note It saves the caller from copying a header, a payload and a trailer into one buffer before esp_at_port_write_data().
+ * @note If the interface has no writev_data operation, or the security channel or self-command mode is active,
+ *       the segments are written one by one through the write_data operation of the interface.
+ * @note Both ways write to the interface directly, in the same way as the AT core calls the write_data operation,
+ *       so they skip whatever the AT core does in esp_at_port_write_data() before that call.
+ *
+ * @param[in] iov: The array of data segments.
+ * @param[in] iovcnt: The number of data segments.
+ *
+ * @return
+ *      - >= 0: the real length of the data written
+ *      - others: fail
+*/
+int32_t esp_at_port_writev(const esp_at_iovec_t *iov, int32_t iovcnt);
+
 /**
  * @brief This function is used to initialize the interface-hooks for communication port.
  *
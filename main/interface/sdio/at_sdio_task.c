@@ -40,46 +40,124 @@ typedef struct sdio_list {
 static esp_at_sdio_list_t *sp_head;
 static esp_at_sdio_list_t *sp_tail;
 static SemaphoreHandle_t s_sdio_rw_sema;
+static SemaphoreHandle_t s_sdio_tx_sema;
+static uint8_t *s_sdio_tx_free_buffer[CONFIG_AT_SDIO_TX_BUFFER_NUM];
+static uint32_t s_sdio_tx_free_num = 0;
 static esp_at_sdio_list_t WORD_ALIGNED_ATTR s_sdio_buffer_list[CONFIG_AT_SDIO_BUFFER_NUM];
 static TaskHandle_t s_task_handle = NULL;
 static const char *TAG = "at-sdio";
 
-static int32_t at_sdio_write_data(uint8_t *data, int32_t len)
+static uint8_t *at_sdio_tx_buffer_get(TickType_t wait_ticks)
 {
-    if (len < 0 || data == NULL) {
-        ESP_LOGE(TAG, "invalid data:%p or len:%d", data, len);
-        return -1;
+    // reclaim the buffers which have been sent to the host
+    void *arg = NULL;
+    while (sdio_slave_send_get_finished(&arg, 0) == ESP_OK) {
+        s_sdio_tx_free_buffer[s_sdio_tx_free_num++] = (uint8_t *)arg;
+    }
+
+    if (s_sdio_tx_free_num == 0) {
+        if (sdio_slave_send_get_finished(&arg, wait_ticks) != ESP_OK) {
+            return NULL;
+        }
+        return (uint8_t *)arg;
+    }
+
+    return s_sdio_tx_free_buffer[--s_sdio_tx_free_num];
+}
+
+static int32_t at_sdio_writev_data(const esp_at_iovec_t *iov, int32_t iovcnt)
+{
+    int32_t len = 0;
+    for (int32_t i = 0; i < iovcnt; ++i) {
+        if (iov[i].len < 0 || (iov[i].len > 0 && iov[i].data == NULL)) {
+            ESP_LOGE(TAG, "invalid iov[%d]:%p,%d", i, iov[i].data, iov[i].len);
+            return -1;
+        }
+        len += iov[i].len;
+    }
+    if (len == 0) {
+        return 0;
     }
 
-    xSemaphoreTake(s_sdio_rw_sema, portMAX_DELAY);
+    xSemaphoreTake(s_sdio_tx_sema, portMAX_DELAY);
 
+    // gather the segments into the dma buffers of the pool, a dma buffer may cross the boundary of the segments.
+    // the buffers are queued to the sdio slave driver without waiting, so that several of them can be in flight.
+    int32_t seg_idx = 0, seg_pos = 0;
     uint32_t had_written_len = 0;
     do {
         int to_send_len = (len - had_written_len) > AT_SDIO_DMA_SIZE ? AT_SDIO_DMA_SIZE : (len - had_written_len);
-        uint8_t *to_send_data = heap_caps_malloc(to_send_len, MALLOC_CAP_DMA);
+        uint8_t *to_send_data = at_sdio_tx_buffer_get(portMAX_DELAY);
         if (to_send_data == NULL) {
-            ESP_LOGE(TAG, "malloc buffer fail");
-            xSemaphoreGive(s_sdio_rw_sema);
-            return 0;
+            ESP_LOGE(TAG, "get tx buffer fail");
+            xSemaphoreGive(s_sdio_tx_sema);
+            return had_written_len;
         }
 
-        memcpy(to_send_data, data + had_written_len, to_send_len);
-        esp_err_t ret = sdio_slave_transmit(to_send_data, to_send_len);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "sdio slave transmit error");
-            free(to_send_data);
-            xSemaphoreGive(s_sdio_rw_sema);
-            return 0;
+        int filled_len = 0;
+        while (filled_len < to_send_len) {
+            int copy_len = at_min(iov[seg_idx].len - seg_pos, to_send_len - filled_len);
+            memcpy(to_send_data + filled_len, iov[seg_idx].data + seg_pos, copy_len);
+            filled_len += copy_len;
+            seg_pos += copy_len;
+            if (seg_pos == iov[seg_idx].len) {
+                seg_idx++;
+                seg_pos = 0;
+            }
         }
 
-        free(to_send_data);
+        esp_err_t ret = sdio_slave_send_queue(to_send_data, to_send_len, to_send_data, portMAX_DELAY);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "sdio slave send queue error:0x%x", ret);
+            s_sdio_tx_free_buffer[s_sdio_tx_free_num++] = to_send_data;
+            xSemaphoreGive(s_sdio_tx_sema);
+            return had_written_len;
+        }
         had_written_len += to_send_len;
     } while (had_written_len != len);
-    xSemaphoreGive(s_sdio_rw_sema);
+    xSemaphoreGive(s_sdio_tx_sema);
 
     return len;
 }
 
+static int32_t at_sdio_write_data(uint8_t *data, int32_t len)
+{
+    if (len < 0 || data == NULL) {
+        ESP_LOGE(TAG, "invalid data:%p or len:%d", data, len);
+        return -1;
+    }
+
+    esp_at_iovec_t iov = {data, len};
+    return at_sdio_writev_data(&iov, 1);
+}
+
+static bool at_sdio_wait_tx_done(int32_t ms)
+{
+    TickType_t start_tick = xTaskGetTickCount();
+    TickType_t wait_ticks = (ms < 0) ? portMAX_DELAY : pdMS_TO_TICKS(ms);
+
+    if (xSemaphoreTake(s_sdio_tx_sema, wait_ticks) != pdTRUE) {
+        return false;
+    }
+
+    // all the buffers are back in the pool means all the queued data has been sent
+    while (s_sdio_tx_free_num < CONFIG_AT_SDIO_TX_BUFFER_NUM) {
+        TickType_t elapsed_ticks = xTaskGetTickCount() - start_tick;
+        if (wait_ticks != portMAX_DELAY && elapsed_ticks >= wait_ticks) {
+            break;
+        }
+        void *arg = NULL;
+        if (sdio_slave_send_get_finished(&arg, (wait_ticks == portMAX_DELAY) ? portMAX_DELAY : wait_ticks - elapsed_ticks) != ESP_OK) {
+            break;
+        }
+        s_sdio_tx_free_buffer[s_sdio_tx_free_num++] = (uint8_t *)arg;
+    }
+    bool done = (s_sdio_tx_free_num == CONFIG_AT_SDIO_TX_BUFFER_NUM);
+    xSemaphoreGive(s_sdio_tx_sema);
+
+    return done;
+}
+
 static int32_t at_sdio_read_data(uint8_t *data, int32_t len)
 {
     if (data == NULL || len < 0) {
@@ -178,8 +256,17 @@ static void at_sdio_init(void)
     };
     ESP_ERROR_CHECK(sdio_slave_initialize(&config));
 
-    // create read-write mutex
+    // create read-write mutex and tx mutex
     s_sdio_rw_sema = xSemaphoreCreateMutex();
+    s_sdio_tx_sema = xSemaphoreCreateMutex();
+    assert(s_sdio_rw_sema != NULL && s_sdio_tx_sema != NULL);
+
+    // allocate the dma buffer pool for transmitting, the buffers are reused during the lifetime of AT
+    for (int loop = 0; loop < CONFIG_AT_SDIO_TX_BUFFER_NUM; loop++) {
+        uint8_t *buffer = heap_caps_malloc(AT_SDIO_DMA_SIZE, MALLOC_CAP_DMA);
+        assert(buffer != NULL);
+        s_sdio_tx_free_buffer[s_sdio_tx_free_num++] = buffer;
+    }
 
     // register and load receive buffer for sdio slave
     sdio_slave_buf_handle_t handle;
@@ -208,7 +295,8 @@ void at_interface_init(void)
         .read_data = at_sdio_read_data,
         .write_data = at_sdio_write_data,
         .get_data_length = NULL,
-        .wait_write_complete = NULL,
+        .wait_write_complete = at_sdio_wait_tx_done,
+        .writev_data = at_sdio_writev_data,
     };
     at_interface_ops_init(&sdio_ops);
 
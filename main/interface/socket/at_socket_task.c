@@ -18,22 +18,137 @@
 #include "esp_netif.h"
 #include "nvs_flash.h"
 
-#define AT_SOCKET_RECV_BUFFER_SIZE              256
-#define AT_RING_BUFFER_SIZE                     (8 * 1024)
+#define AT_SOCKET_RECV_BUFFER_SIZE              CONFIG_AT_SOCKET_RECV_SIZE
+#define AT_RING_BUFFER_SIZE                     CONFIG_AT_SOCKET_RING_BUFFER_SIZE
+#define AT_SOCKET_ITEM_HEADER_SIZE              sizeof(uint32_t)    // the real data length at the head of each ring buffer item
+#define AT_SOCKET_SESSION_IDLE_MS               1000    // switch to another client if the active one keeps silent for so long
+#define AT_SOCKET_SCHEDULE_INTERVAL_MS          10      // the select timeout while some clients are waiting for their session
+#define AT_SOCKET_ESCAPE_GUARD_MS               20      // the silence before and after "+++", the same as AT_UART_PATTERN_TIMEOUT_MS
+#define AT_SOCKET_ESCAPE_LEN                    3       // the length of "+++"
+#define AT_SOCKET_SEND_TIMEOUT_MS               3000    // drop the client if it does not take its responses for so long
 
 #ifdef CONFIG_AT_BASE_ON_SOCKET
 #include "sys/socket.h"
 #include "netdb.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
 #include "esp_at.h"
 #include "esp_at_interface.h"
 
+/**
+ * Each connected client has its own ring buffer. The AT core only reads the ring buffer of the active client,
+ * and the responses are written back to the active client. The session is handed over to the next client which
+ * has pending data, once the active client has no pending data and all of its commands have got a result code.
+ *
+ * The AT core does not tell when a command is done, so it is inferred from the byte stream:
+ *  - only the complete lines which start with "AT" are counted as commands, and only outside of the transmit mode;
+ *  - only a whole line of "OK", "ERROR", "FAIL", "SEND OK" or "SEND FAIL" is taken as a result code;
+ *  - the session is kept during the transmit mode (ESP_AT_STATUS_TRANSMIT of the status callback), and after it
+ *    until the result code of the data, which is missing after "+++";
+ *  - the session is handed over anyway if the active client keeps silent for AT_SOCKET_SESSION_IDLE_MS,
+ *    which covers the commands without a result code and a result code hidden by a message written in the same call.
+ * The unsolicited messages go to whichever client is active at that time.
+*/
+typedef struct {
+    int fd;                         // -1: the slot is free
+    RingbufHandle_t ring_buf;       // the data received from the client
+    uint32_t pending_len;           // the length of data which has not been read by the AT core
+    uint32_t line_len;              // the length of the line which is being read by the AT core, 0: at the start of a line
+    uint8_t line_head[2];           // the first bytes of that line, which tell a command line from the other data
+    uint32_t recv_size;             // the maximum length of one recv()
+    bool dropped;                   // the send to the client has failed, the socket task removes it
+#ifdef CONFIG_AT_SOCKET_ZERO_COPY_RECV
+    uint8_t *item;                  // the ring buffer item which is being read by the AT core
+    uint32_t item_pos;              // the read position in the item data
+#endif
+} at_socket_client_t;
+
+/**
+ * The "+++" escape detector of the passthrough mode, it only looks at the segments of the active client.
+ *
+ * A segment can start the escape only after the guard time of silence, and it must consist of '+' only.
+ * The '+' are held back from the ring buffer until the sequence is complete and followed by the guard time of silence,
+ * then the passthrough mode exits. Otherwise, the held '+' are put back in front of the following data.
+ * So the bulk payload is never scanned: a segment which arrives within the guard time is passed through at once.
+*/
+typedef struct {
+    uint8_t plus_num;               // the number of '+' held back from the ring buffer
+    int64_t last_rx_us;             // the time of the last segment received from the active client
+} at_socket_escape_t;
+
 // static variables
-static int s_client_fd = -1;
+static at_socket_escape_t s_escape;
+static at_socket_client_t s_clients[CONFIG_AT_SOCKET_CLIENT_NUM];
+static int s_active_client = -1;
+static int32_t s_cmd_pending_num = 0;           // the commands of the active client which are waiting for a result code
+static TickType_t s_last_activity_tick = 0;
+static SemaphoreHandle_t s_client_mutex = NULL;
+static SemaphoreHandle_t s_client_tx_mutex = NULL;  // serializes the writers, send() is never called with s_client_mutex held
+static int s_tx_fd = -1;                        // the fd which is being written to, it is not closed until send() returns
+static bool s_tx_fd_close = false;              // the client of s_tx_fd has been removed, the writer closes the fd
 static bool s_trans_mode = false;
-static RingbufHandle_t s_ring_buffer;
 static TaskHandle_t s_task_handle = NULL;
 static const char *TAG = "at-socket";
 
+static size_t at_socket_ring_buffer_read(at_socket_client_t *client, uint8_t *data, int32_t len)
+{
+    size_t data_len = 0;
+
+#ifdef CONFIG_AT_SOCKET_ZERO_COPY_RECV
+    // the items are filled by recv() in place, copy them out across the item boundaries
+    while (data_len < len) {
+        if (!client->item) {
+            size_t item_size = 0;
+            client->item = (uint8_t *)xRingbufferReceive(client->ring_buf, &item_size, 0);
+            if (!client->item) {
+                break;
+            }
+            client->item_pos = 0;
+        }
+
+        uint32_t item_len = *(uint32_t *)client->item;
+        uint32_t copy_len = at_min(item_len - client->item_pos, len - data_len);
+        memcpy(data + data_len, client->item + AT_SOCKET_ITEM_HEADER_SIZE + client->item_pos, copy_len);
+        data_len += copy_len;
+        client->item_pos += copy_len;
+
+        if (client->item_pos >= item_len) {
+            vRingbufferReturnItem(client->ring_buf, client->item);
+            client->item = NULL;
+        }
+    }
+#else
+    uint8_t *recv_data = (uint8_t *)xRingbufferReceiveUpTo(client->ring_buf, &data_len, 0, len);
+    if (recv_data == NULL || data_len == 0) {
+        return 0;
+    }
+    memcpy(data, recv_data, data_len);
+    vRingbufferReturnItem(client->ring_buf, recv_data);
+#endif
+
+    return data_len;
+}
+
+/**
+ * Count the complete command lines read by the AT core, each of them will get a result code.
+*/
+static void at_socket_cmd_line_count(at_socket_client_t *client, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        if (client->line_len < sizeof(client->line_head)) {
+            client->line_head[client->line_len] = data[i];
+        }
+        client->line_len++;
+
+        if (data[i] == '\n') {
+            if (client->line_len > sizeof(client->line_head) && memcmp(client->line_head, "AT", sizeof(client->line_head)) == 0) {
+                s_cmd_pending_num++;
+            }
+            client->line_len = 0;
+        }
+    }
+}
+
 static int32_t at_socket_read_data(uint8_t *data, int32_t len)
 {
     if (data == NULL || len < 0) {
@@ -45,19 +160,41 @@ static int32_t at_socket_read_data(uint8_t *data, int32_t len)
         return 0;
     }
 
-    size_t data_len;
-    uint8_t *recv_data = (uint8_t *)xRingbufferReceiveUpTo(s_ring_buffer, &data_len, 0, len);
-
-    if (recv_data == NULL || data_len == 0) {
-        return 0;
-    } else {
-        memcpy(data, recv_data, data_len);
-        vRingbufferReturnItem(s_ring_buffer, recv_data);
+    size_t data_len = 0;
+    xSemaphoreTake(s_client_mutex, portMAX_DELAY);
+    if (s_active_client >= 0) {
+        at_socket_client_t *client = &s_clients[s_active_client];
+        data_len = at_socket_ring_buffer_read(client, data, len);
+        if (data_len > 0) {
+            // the data of the transmit mode is never a command line
+            if (!s_trans_mode) {
+                at_socket_cmd_line_count(client, data, data_len);
+            }
+            client->pending_len -= data_len;
+            s_last_activity_tick = xTaskGetTickCount();
+        }
     }
+    xSemaphoreGive(s_client_mutex);
 
     return data_len;
 }
 
+static bool at_socket_is_result_code(const uint8_t *data, int32_t len)
+{
+    static const char *result_codes[] = {"OK\r\n", "ERROR\r\n", "FAIL\r\n", "SEND OK\r\n", "SEND FAIL\r\n"};
+
+    // a result code is a whole line, so that e.g. a message which ends with "OK" is not taken for it
+    for (int i = 0; i < sizeof(result_codes) / sizeof(result_codes[0]); ++i) {
+        int32_t code_len = strlen(result_codes[i]);
+        if (len >= code_len && memcmp(data + len - code_len, result_codes[i], code_len) == 0
+                && (len == code_len || data[len - code_len - 1] == '\n')) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 static int32_t at_socket_write_data(uint8_t *data, int32_t len)
 {
     if (len < 0 || data == NULL) {
@@ -70,14 +207,338 @@ static int32_t at_socket_write_data(uint8_t *data, int32_t len)
         return 0;
     }
 
-    if (s_client_fd >= 0 && len > 0) {
-        if (send(s_client_fd, data, len, 0) < 0) {
-            ESP_LOGE(TAG, "cannot send message");
-            return -1;
+    int32_t ret = len;
+    int index = -1;
+    int fd = -1;
+
+    // route the response back to the client which has issued the command,
+    // take its fd under the client mutex, and send outside of it, so that a slow client does not stall the socket task
+    xSemaphoreTake(s_client_tx_mutex, portMAX_DELAY);
+    xSemaphoreTake(s_client_mutex, portMAX_DELAY);
+    if (s_active_client >= 0) {
+        index = s_active_client;
+        fd = s_clients[index].fd;
+        s_tx_fd = fd;
+        if (s_cmd_pending_num > 0 && at_socket_is_result_code(data, len)) {
+            s_cmd_pending_num--;
+        }
+        s_last_activity_tick = xTaskGetTickCount();
+    }
+    xSemaphoreGive(s_client_mutex);
+
+    if (fd >= 0) {
+        // it returns less than len if the client does not take the data within AT_SOCKET_SEND_TIMEOUT_MS
+        if (send(fd, data, len, 0) != len) {
+            ESP_LOGE(TAG, "cannot send message, drop client %d", index);
+            ret = -1;
+        }
+
+        xSemaphoreTake(s_client_mutex, portMAX_DELAY);
+        if (s_tx_fd_close) {
+            close(fd);
+            s_tx_fd_close = false;
+        } else if (ret < 0) {
+            s_clients[index].dropped = true;
+        }
+        s_tx_fd = -1;
+        xSemaphoreGive(s_client_mutex);
+    }
+    xSemaphoreGive(s_client_tx_mutex);
+
+    return ret;
+}
+
+static void at_socket_client_tune(int fd)
+{
+    // a client which stops reading must not block the AT core in send() forever
+    struct timeval send_timeout = {
+        .tv_sec = AT_SOCKET_SEND_TIMEOUT_MS / 1000,
+        .tv_usec = (AT_SOCKET_SEND_TIMEOUT_MS % 1000) * 1000,
+    };
+    if (setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout)) != 0) {
+        ESP_LOGW(TAG, "set SO_SNDTIMEO failed");
+    }
+
+#ifdef CONFIG_AT_SOCKET_TCP_NODELAY
+    // the responses are short, do not hold them back for coalescing
+    int nodelay = 1;
+    if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay)) != 0) {
+        ESP_LOGW(TAG, "set TCP_NODELAY failed");
+    }
+#endif
+
+#if defined(CONFIG_LWIP_SO_RCVBUF) && (CONFIG_AT_SOCKET_RCVBUF_SIZE > 0)
+    int rcvbuf = CONFIG_AT_SOCKET_RCVBUF_SIZE;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) != 0) {
+        ESP_LOGW(TAG, "set SO_RCVBUF failed");
+    }
+#endif
+}
+
+static int at_socket_client_add(int fd)
+{
+#ifdef CONFIG_AT_SOCKET_ZERO_COPY_RECV
+    RingbufHandle_t ring_buf = xRingbufferCreate(AT_RING_BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+#else
+    RingbufHandle_t ring_buf = xRingbufferCreate(AT_RING_BUFFER_SIZE, RINGBUF_TYPE_BYTEBUF);
+#endif
+    if (!ring_buf) {
+        ESP_LOGE(TAG, "create ringbuf failed");
+        return -1;
+    }
+    at_socket_client_tune(fd);
+
+    int index = -1;
+    xSemaphoreTake(s_client_mutex, portMAX_DELAY);
+    for (int i = 0; i < CONFIG_AT_SOCKET_CLIENT_NUM; ++i) {
+        if (s_clients[i].fd < 0) {
+            s_clients[i].fd = fd;
+            s_clients[i].ring_buf = ring_buf;
+            s_clients[i].pending_len = 0;
+            s_clients[i].line_len = 0;
+            s_clients[i].dropped = false;
+            // one recv() must fit in an empty ring buffer, or the client is never selected for reading,
+            // and an item can not be larger than a half of the no-split ring buffer
+            s_clients[i].recv_size = at_min(AT_SOCKET_RECV_BUFFER_SIZE, xRingbufferGetMaxItemSize(ring_buf) - AT_SOCKET_ITEM_HEADER_SIZE);
+#ifdef CONFIG_AT_SOCKET_ZERO_COPY_RECV
+            s_clients[i].item = NULL;
+#endif
+            index = i;
+            break;
+        }
+    }
+    xSemaphoreGive(s_client_mutex);
+
+    if (index < 0) {
+        vRingbufferDelete(ring_buf);
+    }
+    return index;
+}
+
+static void at_socket_client_remove(int index)
+{
+    xSemaphoreTake(s_client_mutex, portMAX_DELAY);
+    at_socket_client_t *client = &s_clients[index];
+    if (client->fd == s_tx_fd) {
+        // the writer is still in send(), wake it up, and leave the fd to it so that the fd is not reused meanwhile
+        shutdown(client->fd, SHUT_RDWR);
+        s_tx_fd_close = true;
+    } else {
+        close(client->fd);
+    }
+#ifdef CONFIG_AT_SOCKET_ZERO_COPY_RECV
+    if (client->item) {
+        vRingbufferReturnItem(client->ring_buf, client->item);
+        client->item = NULL;
+    }
+#endif
+    vRingbufferDelete(client->ring_buf);
+    client->fd = -1;
+    client->ring_buf = NULL;
+    client->pending_len = 0;
+    client->dropped = false;
+    if (s_active_client == index) {
+        s_active_client = -1;
+        s_cmd_pending_num = 0;
+        s_escape.plus_num = 0;
+    }
+    xSemaphoreGive(s_client_mutex);
+}
+
+static bool at_socket_ring_buffer_write(at_socket_client_t *client, const uint8_t *data, uint32_t len)
+{
+#ifdef CONFIG_AT_SOCKET_ZERO_COPY_RECV
+    uint32_t *item = NULL;
+    if (xRingbufferSendAcquire(client->ring_buf, (void **)&item, AT_SOCKET_ITEM_HEADER_SIZE + len, 0) == pdFALSE) {
+        return false;
+    }
+    *item = len;
+    memcpy(item + 1, data, len);
+    return xRingbufferSendComplete(client->ring_buf, item) == pdTRUE;
+#else
+    return xRingbufferSend(client->ring_buf, data, len, 0) == pdTRUE;
+#endif
+}
+
+/**
+ * Feed a segment of the active client into the escape detector.
+ *
+ * @return true if the segment is a part of "+++" and it is held back
+*/
+static bool at_socket_escape_feed(const uint8_t *data, int32_t len, int64_t now_us)
+{
+    bool idle_before = (now_us - s_escape.last_rx_us) >= AT_SOCKET_ESCAPE_GUARD_MS * 1000;
+    s_escape.last_rx_us = now_us;
+
+    if (!s_trans_mode) {
+        s_escape.plus_num = 0;
+        return false;
+    }
+
+    // the first '+' must follow the guard time of silence, and the following ones must arrive within the guard time
+    bool candidate = (s_escape.plus_num == 0) ? idle_before : (s_escape.plus_num < AT_SOCKET_ESCAPE_LEN && !idle_before);
+    if (!candidate || len > AT_SOCKET_ESCAPE_LEN - s_escape.plus_num) {
+        return false;
+    }
+    for (int32_t i = 0; i < len; ++i) {
+        if (data[i] != '+') {
+            return false;
+        }
+    }
+
+    s_escape.plus_num += len;
+    return true;
+}
+
+/**
+ * Check whether the held "+++" is followed by the guard time of silence.
+ *
+ * @return true if the escape detector is still waiting for the guard time
+*/
+static bool at_socket_escape_poll(void)
+{
+    if (s_escape.plus_num == 0) {
+        return false;
+    }
+
+    if (!s_trans_mode) {
+        // the passthrough mode has exited by other means, do not feed the held '+' into the command line
+        s_escape.plus_num = 0;
+        return false;
+    }
+
+    if ((esp_timer_get_time() - s_escape.last_rx_us) < AT_SOCKET_ESCAPE_GUARD_MS * 1000) {
+        return true;
+    }
+
+    uint8_t plus_num = s_escape.plus_num;
+    s_escape.plus_num = 0;
+    if (plus_num == AT_SOCKET_ESCAPE_LEN) {
+        ESP_LOGI(TAG, "exit passthrough mode");
+        esp_at_transmit_terminal();
+        return false;
+    }
+
+    // an incomplete escape is just the passthrough data
+    bool notify = false;
+    xSemaphoreTake(s_client_mutex, portMAX_DELAY);
+    if (s_active_client >= 0 && at_socket_ring_buffer_write(&s_clients[s_active_client], (const uint8_t *)"+++", plus_num)) {
+        s_clients[s_active_client].pending_len += plus_num;
+        notify = true;
+    }
+    xSemaphoreGive(s_client_mutex);
+    if (notify) {
+        esp_at_port_recv_data_notify(plus_num, portMAX_DELAY);
+    }
+
+    return false;
+}
+
+/**
+ * Receive the data from a client into its ring buffer, and notify the AT core if the client is active.
+ *
+ * @return the length of data received from the client, <= 0 if the connection is closed
+*/
+static int at_socket_client_recv(int index, uint8_t *buffer)
+{
+    at_socket_client_t *client = &s_clients[index];
+    uint8_t *data = buffer;
+
+#ifdef CONFIG_AT_SOCKET_ZERO_COPY_RECV
+    // receive into the ring buffer item directly, its real data length is written into the item header
+    uint32_t *item = NULL;
+    if (xRingbufferSendAcquire(client->ring_buf, (void **)&item, AT_SOCKET_ITEM_HEADER_SIZE + client->recv_size, 0) == pdFALSE) {
+        // keep the connection, the data stays in the socket until there is room in the ring buffer
+        ESP_LOGE(TAG, "cannot acquire ringbuf");
+        return 1;
+    }
+    data = (uint8_t *)(item + 1);
+#endif
+
+    // leave room in front of the data for the '+' held back by the escape detector
+    bool active = (index == s_active_client);
+    uint32_t held_len = active ? s_escape.plus_num : 0;
+    int byte_num = recv(client->fd, data + held_len, client->recv_size - held_len, 0);
+    int32_t data_len = 0;
+
+    if (byte_num > 0) {
+        if (!active) {
+            data_len = byte_num;
+        } else if (!at_socket_escape_feed(data + held_len, byte_num, esp_timer_get_time())) {
+            // it is not an escape, put the held '+' back in front of the data
+            memset(data, '+', held_len);
+            s_escape.plus_num = 0;
+            data_len = held_len + byte_num;
+        }
+    }
+
+    xSemaphoreTake(s_client_mutex, portMAX_DELAY);
+#ifdef CONFIG_AT_SOCKET_ZERO_COPY_RECV
+    // the acquired item must be completed anyway, an empty item is skipped by the reader
+    *item = data_len;
+    xRingbufferSendComplete(client->ring_buf, item);
+#else
+    if (data_len > 0 && xRingbufferSend(client->ring_buf, data, data_len, 0) == pdFALSE) {
+        ESP_LOGE(TAG, "cannot send data to ringbuf");
+        data_len = 0;
+    }
+#endif
+    client->pending_len += data_len;
+    xSemaphoreGive(s_client_mutex);
+
+    if (active && data_len > 0) {
+        esp_at_port_recv_data_notify(data_len, portMAX_DELAY);
+    }
+
+    return byte_num;
+}
+
+/**
+ * Hand the session over to the next client which has pending data, if the active client has finished its commands.
+ *
+ * @return true if some clients are still waiting for the session
+*/
+static bool at_socket_session_schedule(void)
+{
+    int32_t notify_len = 0;
+    bool waiting = false;
+
+    xSemaphoreTake(s_client_mutex, portMAX_DELAY);
+    bool can_switch = true;
+    if (s_active_client >= 0) {
+        at_socket_client_t *active = &s_clients[s_active_client];
+        if (s_trans_mode || active->pending_len > 0 || active->line_len > 0) {
+            can_switch = false;
+        } else if (s_cmd_pending_num > 0
+                   && (xTaskGetTickCount() - s_last_activity_tick) < pdMS_TO_TICKS(AT_SOCKET_SESSION_IDLE_MS)) {
+            can_switch = false;
         }
     }
 
-    return len;
+    int start = (s_active_client >= 0) ? s_active_client + 1 : 0;
+    for (int i = 0; i < CONFIG_AT_SOCKET_CLIENT_NUM; ++i) {
+        int index = (start + i) % CONFIG_AT_SOCKET_CLIENT_NUM;
+        if (index == s_active_client || s_clients[index].fd < 0 || s_clients[index].pending_len == 0) {
+            continue;
+        }
+        if (!can_switch) {
+            waiting = true;
+            break;
+        }
+        ESP_LOGD(TAG, "session: client %d -> client %d", s_active_client, index);
+        s_active_client = index;
+        s_cmd_pending_num = 0;
+        s_last_activity_tick = xTaskGetTickCount();
+        notify_len = s_clients[index].pending_len;
+        break;
+    }
+    xSemaphoreGive(s_client_mutex);
+
+    if (notify_len > 0) {
+        esp_at_port_recv_data_notify(notify_len, portMAX_DELAY);
+    }
+
+    return waiting;
 }
 
 static void socket_task(void *params)
@@ -101,72 +562,113 @@ static void socket_task(void *params)
     }
 
     // listen
-    if (listen(server_fd, 1) == -1) {
+    if (listen(server_fd, CONFIG_AT_SOCKET_CLIENT_NUM) == -1) {
         ESP_LOGE(TAG, "cannot listen socket");
         goto exit_task;
     }
     ESP_LOGD(TAG, "socket listening...");
 
+    // create a buffer to store data from clients, the zero-copy mode receives into the ring buffers directly
+    uint8_t *buffer = NULL;
+#ifndef CONFIG_AT_SOCKET_ZERO_COPY_RECV
+    buffer = (uint8_t *)malloc(AT_SOCKET_RECV_BUFFER_SIZE * sizeof(uint8_t));
+    if (!buffer) {
+        ESP_LOGE(TAG, "no memory for recv buffer");
+        goto exit_task;
+    }
+#endif
+
     // wait for AT ready
     ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
+    bool waiting = false;
+    bool escaping = false;
     for (;;) {
-        // accept a new client
-        socklen_t len;
-        struct sockaddr_in remote_addr;
-        ESP_LOGD(TAG, "wait for a new client...");
-        s_client_fd = accept(server_fd, (struct sockaddr*) &remote_addr, &len);
-        ESP_LOGD(TAG, "accept a new client: %d", s_client_fd);
-
-        if (s_client_fd == -1) {
-            ESP_LOGE(TAG, "cannot accept socket");
-            break;
+        // set fd_set: the server fd if there is a free client slot, and the clients which have room in their ring buffers
+        fd_set read_fd_set;
+        FD_ZERO(&read_fd_set);
+        int max_fd = -1;
+        bool throttled = false;
+        bool slot_free = false;
+        bool dropped[CONFIG_AT_SOCKET_CLIENT_NUM] = {false};
+        bool drop = false;
+        xSemaphoreTake(s_client_mutex, portMAX_DELAY);
+        for (int i = 0; i < CONFIG_AT_SOCKET_CLIENT_NUM; ++i) {
+            if (s_clients[i].fd < 0) {
+                slot_free = true;
+            } else if (s_clients[i].dropped) {
+                dropped[i] = drop = true;
+            } else if (xRingbufferGetCurFreeSize(s_clients[i].ring_buf) >= AT_SOCKET_ITEM_HEADER_SIZE + s_clients[i].recv_size) {
+                FD_SET(s_clients[i].fd, &read_fd_set);
+                max_fd = at_max(max_fd, s_clients[i].fd);
+            } else {
+                throttled = true;
+            }
         }
-
-        // create a buffer to store data from client
-        uint8_t *buffer = (uint8_t *)malloc(AT_SOCKET_RECV_BUFFER_SIZE * sizeof(uint8_t));
-
-        for (;;) {
-            // set fd_set
-            fd_set server_fd_set;
-            FD_ZERO(&server_fd_set);
-            FD_SET(s_client_fd, &server_fd_set);
-
-            if (select(s_client_fd + 1, &server_fd_set, NULL, NULL, NULL) >= 0) {
-                // receive data from client
-                if (FD_ISSET(s_client_fd, &server_fd_set)) {
-                    int byte_num = recv(s_client_fd, buffer, AT_SOCKET_RECV_BUFFER_SIZE, 0);
-
-                    // exit transparent transmition mode
-                    if (s_trans_mode && (byte_num == 3) && (memcmp(buffer, "+++", 3) == 0)) {
-                        ESP_LOGI(TAG, "exit passthrough mode");
-                        esp_at_transmit_terminal();
-                        continue;
-                    }
-
-                    if (byte_num > 0) {
-                        if (xRingbufferSend(s_ring_buffer, buffer, byte_num, portMAX_DELAY) == pdFALSE) {
-                            ESP_LOGE(TAG, "cannot send data to ringbuf");
-                            continue;
-                        }
-                        esp_at_port_recv_data_notify(byte_num, portMAX_DELAY);
-                    } else {
-                        close(s_client_fd);
-                        s_client_fd = -1;
-                        ESP_LOGD(TAG, "connection closed");
-                        break;
-                    }
+        xSemaphoreGive(s_client_mutex);
+
+        // remove the clients which have failed to take their responses
+        if (drop) {
+            for (int i = 0; i < CONFIG_AT_SOCKET_CLIENT_NUM; ++i) {
+                if (dropped[i]) {
+                    ESP_LOGD(TAG, "drop client: %d", s_clients[i].fd);
+                    at_socket_client_remove(i);
                 }
+            }
+            continue;
+        }
+
+        if (slot_free) {
+            FD_SET(server_fd, &read_fd_set);
+            max_fd = at_max(max_fd, server_fd);
+        }
+
+        // poll periodically while some clients are waiting for their session or for room in their ring buffers,
+        // or the escape detector is waiting for the guard time
+        struct timeval timeout = {
+            .tv_sec = 0,
+            .tv_usec = AT_SOCKET_SCHEDULE_INTERVAL_MS * 1000,
+        };
+        int ret = select(max_fd + 1, &read_fd_set, NULL, NULL, (waiting || throttled || escaping) ? &timeout : NULL);
+        if (ret < 0) {
+            ESP_LOGE(TAG, "cannot select socket");
+            vTaskDelay(pdMS_TO_TICKS(AT_SOCKET_SCHEDULE_INTERVAL_MS));
+            continue;
+        }
+
+        // accept a new client
+        if (slot_free && FD_ISSET(server_fd, &read_fd_set)) {
+            struct sockaddr_in remote_addr;
+            socklen_t len = sizeof(remote_addr);
+            int client_fd = accept(server_fd, (struct sockaddr*) &remote_addr, &len);
+            if (client_fd < 0) {
+                ESP_LOGE(TAG, "cannot accept socket");
+            } else if (at_socket_client_add(client_fd) < 0) {
+                close(client_fd);
             } else {
-                ESP_LOGE(TAG, "cannot select socket");
+                ESP_LOGD(TAG, "accept a new client: %d", client_fd);
+            }
+        }
+
+        // receive data from clients
+        for (int i = 0; i < CONFIG_AT_SOCKET_CLIENT_NUM; ++i) {
+            int client_fd = s_clients[i].fd;
+            if (client_fd < 0 || !FD_ISSET(client_fd, &read_fd_set)) {
                 continue;
             }
+
+            if (at_socket_client_recv(i, buffer) <= 0) {
+                at_socket_client_remove(i);
+                ESP_LOGD(TAG, "connection closed: %d", client_fd);
+            }
         }
 
-        free(buffer);
-        buffer = NULL;
+        escaping = at_socket_escape_poll();
+        waiting = at_socket_session_schedule();
     }
 
+    free(buffer);
+
 exit_task:
     if (server_fd >= 0) {
         close(server_fd);
@@ -177,8 +679,16 @@ exit_task:
 
 static void at_socket_transmit_mode_switch_cb(esp_at_status_type status)
 {
+    // the active client keeps the session during the whole transmit mode, see at_socket_session_schedule()
+    xSemaphoreTake(s_client_mutex, portMAX_DELAY);
     switch (status) {
     case ESP_AT_STATUS_NORMAL:
+        if (s_trans_mode && s_active_client >= 0) {
+            // the data is not a part of any command line, and it still waits for the result code of the data
+            s_clients[s_active_client].line_len = 0;
+            s_cmd_pending_num = 1;
+            s_last_activity_tick = xTaskGetTickCount();
+        }
         s_trans_mode = false;
         break;
 
@@ -186,16 +696,21 @@ static void at_socket_transmit_mode_switch_cb(esp_at_status_type status)
         s_trans_mode = true;
         break;
     }
+    xSemaphoreGive(s_client_mutex);
 }
 
 static void at_socket_init(void)
 {
-    // create a ring buffer for rx data
-    s_ring_buffer = xRingbufferCreate(AT_RING_BUFFER_SIZE, RINGBUF_TYPE_BYTEBUF);
-    if (!s_ring_buffer) {
-        ESP_LOGE(TAG, "create ringbuf failed");
+    // the ring buffer of each client is created when the client is connected
+    s_client_mutex = xSemaphoreCreateMutex();
+    s_client_tx_mutex = xSemaphoreCreateMutex();
+    if (!s_client_mutex || !s_client_tx_mutex) {
+        ESP_LOGE(TAG, "create client mutex failed");
         return;
     }
+    for (int i = 0; i < CONFIG_AT_SOCKET_CLIENT_NUM; ++i) {
+        s_clients[i].fd = -1;
+    }
 
     // set wifi mode for socket interface
     wifi_mode_t mode;
@@ -212,7 +727,8 @@ static void at_socket_init(void)
     esp_netif_ip_info_t ip;
     esp_netif_t * ap_if = esp_netif_get_handle_from_ifkey("WIFI_AP_DEF");
     ESP_ERROR_CHECK(esp_netif_get_ip_info(ap_if, &ip));
-    ESP_AT_LOGI(TAG, "softap: (%s) started, listen on (" IPSTR ":%d)", config.ap.ssid, IP2STR(&ip.ip), CONFIG_AT_SOCKET_PORT);
+    ESP_AT_LOGI(TAG, "softap: (%s) started, listen on (" IPSTR ":%d), max clients: %d",
+                config.ap.ssid, IP2STR(&ip.ip), CONFIG_AT_SOCKET_PORT, CONFIG_AT_SOCKET_CLIENT_NUM);
 
     xTaskCreate(&socket_task, "socket_task", 4096, NULL, 5, &s_task_handle);
 }
@@ -13,6 +13,7 @@
 #include "freertos/stream_buffer.h"
 #include "esp_system.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 
 #ifdef CONFIG_AT_BASE_ON_SPI
 #include "driver/gpio.h"
@@ -20,8 +21,17 @@
 #include "esp_at.h"
 #include "esp_at_interface.h"
 
-#define AT_SPI_DMA_SIZE                 4092
+#define AT_SPI_DMA_SIZE                 CONFIG_AT_SPI_DMA_SIZE
+#define AT_SPI_DMA_SIZE_LEGACY          4092        // the transaction size used before the master announces its own
 #define SLAVE_CONFIG_ADDR               4
+#define SLAVE_NEGO_ADDR                 12
+#define SLAVE_NEGO_MAGIC                0xFD
+
+#ifdef CONFIG_AT_SPI_PIPELINE_MODE
+#define AT_SPI_RX_TRANS_SIZE_MAX        AT_SPI_DMA_SIZE
+#else
+#define AT_SPI_RX_TRANS_SIZE_MAX        at_min(AT_SPI_DMA_SIZE, CONFIG_RX_STREAM_BUFFER_SIZE)
+#endif
 
 typedef enum {
     SPI_NULL = 0,
@@ -37,17 +47,47 @@ typedef struct {
     uint32_t     direct : 8;
     uint32_t     seq_num : 8;
     uint32_t     transmit_len : 16;
+    uint32_t     max_trans_len : 16;    // the maximum length of one master -> slave transaction, the master which reads only the first word ignores it
+    uint32_t     nego_req : 1;          // 1: the master has not announced its maximum length since the slave started, please announce it
+    uint32_t     reserved : 15;
 } spi_rd_status_opt_t;
 
+typedef struct {
+    uint32_t     magic : 8;             // SLAVE_NEGO_MAGIC
+    uint32_t     reserved : 8;
+    uint32_t     max_trans_len : 16;    // the maximum length of one slave -> master transaction
+} spi_nego_opt_t;
+
+#ifdef CONFIG_AT_SPI_PIPELINE_MODE
+typedef struct at_spi_rx_desc {
+    spi_slave_hd_data_t trans;          // the dma descriptor queued to the spi slave driver
+    struct at_spi_rx_desc *next;
+    uint32_t left_len;
+    uint32_t pos;
+} at_spi_rx_desc_t;
+#endif
+
 // static variables
 static uint8_t s_init_tx_flag = 0;
 static QueueHandle_t s_spi_msg_queue;
 static SemaphoreHandle_t s_spi_rw_sema;
 static uint8_t s_spi_slave_tx_seq_num = 0;
 static uint8_t s_spi_slave_rx_seq_num = 0;
+static uint16_t s_spi_tx_trans_size = AT_SPI_DMA_SIZE_LEGACY;
+static bool s_spi_nego_done = false;
+#ifndef CONFIG_AT_SPI_PIPELINE_MODE
 static StreamBufferHandle_t s_spi_slave_rx_ring_buf = NULL;
+#endif
 static StreamBufferHandle_t s_spi_slave_tx_ring_buf = NULL;
 static TaskHandle_t s_task_handle = NULL;
+static at_spi_stats_t s_spi_stats;
+#ifdef CONFIG_AT_SPI_PIPELINE_MODE
+static at_spi_rx_desc_t s_spi_rx_desc[CONFIG_AT_SPI_PIPELINE_DESC_NUM];
+static at_spi_rx_desc_t *sp_rx_head = NULL;
+static at_spi_rx_desc_t *sp_rx_tail = NULL;
+static uint32_t s_spi_rx_pending_len = 0;
+static SemaphoreHandle_t s_spi_rx_desc_sema;        // counts the rx descriptors queued to the spi slave driver
+#endif
 
 static const char *TAG = "at-spi";
 
@@ -75,14 +115,18 @@ static bool master_write_buffer_cb(void *arg, spi_slave_hd_event_t *event, BaseT
 inline static void at_spi_write_transmit_len(spi_mode_t spi_mode, uint16_t transmit_len)
 {
     ESP_EARLY_LOGV(TAG, "tx status: %d, %d", (uint32_t)spi_mode, transmit_len);
-    if (transmit_len > CONFIG_TX_STREAM_BUFFER_SIZE) {
+    // slave -> master data comes from the tx stream buffer, master -> slave data goes to one rx transaction
+    uint16_t max_len = (spi_mode == SPI_SLAVE_RD) ? AT_SPI_RX_TRANS_SIZE_MAX : CONFIG_TX_STREAM_BUFFER_SIZE;
+    if (transmit_len > max_len) {
         ESP_EARLY_LOGI(TAG, "too large tx len: %d", transmit_len);
         return;
     }
 
-    spi_rd_status_opt_t rd_status_opt;
+    spi_rd_status_opt_t rd_status_opt = {0};
     rd_status_opt.direct = spi_mode;
     rd_status_opt.transmit_len = transmit_len;
+    rd_status_opt.max_trans_len = AT_SPI_RX_TRANS_SIZE_MAX;
+    rd_status_opt.nego_req = !s_spi_nego_done;
     if (spi_mode == SPI_SLAVE_WR) {
         // slave -> master
         rd_status_opt.seq_num = ++s_spi_slave_tx_seq_num;
@@ -94,6 +138,31 @@ inline static void at_spi_write_transmit_len(spi_mode_t spi_mode, uint16_t trans
     spi_slave_hd_write_buffer(SPI2_HOST, SLAVE_CONFIG_ADDR, (uint8_t *)&rd_status_opt, sizeof(spi_rd_status_opt_t));
 }
 
+// the master announces the maximum length it can receive in one transaction by writing the negotiation word,
+// which triggers master_write_buffer_cb() as a write request does
+static bool at_spi_nego_check(void)
+{
+    spi_nego_opt_t nego_opt = {0};
+    spi_slave_hd_read_buffer(SPI2_HOST, SLAVE_NEGO_ADDR, (uint8_t *)&nego_opt, sizeof(spi_nego_opt_t));
+    if (nego_opt.magic != SLAVE_NEGO_MAGIC) {
+        return false;
+    }
+
+    // consume the negotiation word, so that the next buffer write is handled as a write request
+    spi_nego_opt_t empty_opt = {0};
+    spi_slave_hd_write_buffer(SPI2_HOST, SLAVE_NEGO_ADDR, (uint8_t *)&empty_opt, sizeof(spi_nego_opt_t));
+
+    if (nego_opt.max_trans_len == 0) {
+        s_spi_tx_trans_size = AT_SPI_DMA_SIZE_LEGACY;
+    } else {
+        s_spi_tx_trans_size = at_min(nego_opt.max_trans_len, AT_SPI_DMA_SIZE);
+    }
+    s_spi_nego_done = true;
+    ESP_LOGI(TAG, "master max trans len:%d, negotiated tx len:%d", nego_opt.max_trans_len, s_spi_tx_trans_size);
+
+    return true;
+}
+
 static int32_t at_spi_read_data(uint8_t *data, int32_t len)
 {
     if (data == NULL || len < 0) {
@@ -107,8 +176,37 @@ static int32_t at_spi_read_data(uint8_t *data, int32_t len)
     }
     ESP_LOGD(TAG, "to read len: %d", len);
 
+#ifdef CONFIG_AT_SPI_PIPELINE_MODE
+    // copy out of the received dma buffers directly, and give a buffer back to the driver once it is drained
+    uint32_t had_read_len = 0;
+    while (had_read_len < len && sp_rx_head) {
+        at_spi_rx_desc_t *desc = sp_rx_head;
+        uint32_t copy_len = at_min(len - had_read_len, desc->left_len);
+        memcpy(data + had_read_len, desc->trans.data + desc->pos, copy_len);
+        desc->pos += copy_len;
+        desc->left_len -= copy_len;
+        had_read_len += copy_len;
+
+        at_spi_mutex_lock();
+        s_spi_rx_pending_len -= copy_len;
+        if (desc->left_len == 0) {
+            sp_rx_head = desc->next;
+            if (!sp_rx_head) {
+                sp_rx_tail = NULL;
+            }
+        }
+        at_spi_mutex_unlock();
+
+        if (desc->left_len == 0) {
+            desc->next = NULL;
+            ESP_ERROR_CHECK(spi_slave_hd_queue_trans(SPI2_HOST, SPI_SLAVE_CHAN_RX, &desc->trans, portMAX_DELAY));
+            xSemaphoreGive(s_spi_rx_desc_sema);
+        }
+    }
+#else
     uint32_t had_read_len = 0;
     had_read_len = xStreamBufferReceive(s_spi_slave_rx_ring_buf, (void *)data, len, 0);
+#endif
     if (had_read_len != len) {
         ESP_LOGD(TAG, "read len error (expect:%d, actual:%d)", len, had_read_len);
     }
@@ -116,6 +214,21 @@ static int32_t at_spi_read_data(uint8_t *data, int32_t len)
     return had_read_len;
 }
 
+static void at_spi_tx_start(void)
+{
+    at_spi_mutex_lock();
+    if (s_init_tx_flag == 0) {
+        s_init_tx_flag = 1;
+        spi_msg_t spi_msg = {
+            .direct = SPI_SLAVE_WR,
+        };
+        if (xQueueSend(s_spi_msg_queue, (void *)&spi_msg, 0) != pdPASS) {
+            ESP_LOGE(TAG, "send to msg queue error");
+        }
+    }
+    at_spi_mutex_unlock();
+}
+
 static int32_t at_spi_write_data(uint8_t *data, int32_t len)
 {
     if (len < 0 || len > CONFIG_TX_STREAM_BUFFER_SIZE || data == NULL) {
@@ -135,30 +248,211 @@ static int32_t at_spi_write_data(uint8_t *data, int32_t len)
         return -1;
     }
 
-    at_spi_mutex_lock();
-    if (s_init_tx_flag == 0) {
-        s_init_tx_flag = 1;
-        spi_msg_t spi_msg = {
-            .direct = SPI_SLAVE_WR,
-        };
-        if (xQueueSend(s_spi_msg_queue, (void *)&spi_msg, 0) != pdPASS) {
-            ESP_LOGE(TAG, "send to msg queue error");
+    at_spi_tx_start();
+
+    return len;
+}
+
+static int32_t at_spi_writev_data(const esp_at_iovec_t *iov, int32_t iovcnt)
+{
+    int32_t len = 0;
+    for (int32_t i = 0; i < iovcnt; ++i) {
+        if (iov[i].len < 0 || (iov[i].len > 0 && iov[i].data == NULL)) {
+            ESP_LOGE(TAG, "invalid iov[%d]:%p,%d", i, iov[i].data, iov[i].len);
+            return -1;
+        }
+        len += iov[i].len;
+    }
+    if (len > CONFIG_TX_STREAM_BUFFER_SIZE) {
+        ESP_LOGE(TAG, "invalid len:%d", len);
+        return -1;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    ESP_LOGD(TAG, "to writev len: %d", len);
+
+    // fill all the segments into the stream buffer before the transmission is started,
+    // so that they can be sent to the master in one spi transaction
+    for (int32_t i = 0; i < iovcnt; ++i) {
+        if (iov[i].len == 0) {
+            continue;
+        }
+        if (xStreamBufferSend(s_spi_slave_tx_ring_buf, iov[i].data, iov[i].len, portMAX_DELAY) != iov[i].len) {
+            ESP_LOGE(TAG, "stream buffer send error");
+            return -1;
         }
     }
-    at_spi_mutex_unlock();
+
+    at_spi_tx_start();
 
     return len;
 }
 
 static int32_t at_spi_get_data_len(void)
 {
+#ifdef CONFIG_AT_SPI_PIPELINE_MODE
+    return s_spi_rx_pending_len;
+#else
     if (!s_spi_slave_rx_ring_buf) {
         return 0;
     }
 
     return xStreamBufferBytesAvailable(s_spi_slave_rx_ring_buf);
+#endif
 }
 
+void at_spi_stats_get(at_spi_stats_t *stats)
+{
+    at_spi_mutex_lock();
+    memcpy(stats, &s_spi_stats, sizeof(at_spi_stats_t));
+    at_spi_mutex_unlock();
+}
+
+static void at_spi_stats_update(spi_mode_t spi_mode, uint32_t len)
+{
+    at_spi_mutex_lock();
+    if (spi_mode == SPI_SLAVE_RD) {
+        s_spi_stats.rx_bytes += len;
+        s_spi_stats.rx_trans++;
+    } else {
+        s_spi_stats.tx_bytes += len;
+        s_spi_stats.tx_trans++;
+    }
+    at_spi_mutex_unlock();
+}
+
+#ifdef CONFIG_AT_SPI_PIPELINE_MODE
+static void at_spi_task(void *params)
+{
+    // two tx dma buffers: one is being read by the master while the other one is filled from the tx stream buffer
+    uint8_t *tx_buffer[2];
+    uint32_t tx_len[2] = {0};
+    uint8_t tx_idx = 0;
+    for (int i = 0; i < 2; ++i) {
+        tx_buffer[i] = heap_caps_malloc(AT_SPI_DMA_SIZE, MALLOC_CAP_DMA);
+        if (tx_buffer[i] == NULL) {
+            ESP_LOGE(TAG, "malloc failed");
+            return;
+        }
+    }
+
+    // wait for AT ready
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    spi_slave_hd_data_t *ret_trans;
+    spi_slave_hd_data_t slave_trans = {0};
+    while (1) {
+        spi_msg_t trans_msg = {0};
+
+        // set handshake pin to low level
+        gpio_set_level(CONFIG_SPI_HANDSHAKE_PIN, 0);
+
+        xQueueReceive(s_spi_msg_queue, (void*)&trans_msg, portMAX_DELAY);
+        ESP_LOGD(TAG, "direct: %d", trans_msg.direct);
+
+        if (trans_msg.direct == SPI_SLAVE_RD) {
+            // master -> slave
+            if (at_spi_nego_check()) {
+                continue;
+            }
+
+            // the rx descriptors are queued in advance, wait until at least one of them is not held by the AT core
+            xSemaphoreTake(s_spi_rx_desc_sema, portMAX_DELAY);
+
+            // tell master transmit mode is master send
+            at_spi_write_transmit_len(SPI_SLAVE_RD, AT_SPI_RX_TRANS_SIZE_MAX);
+
+            // slave is ready to rx, notify master to do next translation
+            gpio_set_level(CONFIG_SPI_HANDSHAKE_PIN, 1);
+
+            ESP_ERROR_CHECK(spi_slave_hd_get_trans_res(SPI2_HOST, SPI_SLAVE_CHAN_RX, &ret_trans, portMAX_DELAY));
+            at_spi_rx_desc_t *desc = (at_spi_rx_desc_t *)ret_trans->arg;
+            if (ret_trans->trans_len > AT_SPI_DMA_SIZE || ret_trans->trans_len <= 0) {
+                ESP_LOGE(TAG, "recv wrong len: %d", ret_trans->trans_len);
+                ESP_ERROR_CHECK(spi_slave_hd_queue_trans(SPI2_HOST, SPI_SLAVE_CHAN_RX, &desc->trans, portMAX_DELAY));
+                xSemaphoreGive(s_spi_rx_desc_sema);
+                continue;
+            }
+            at_spi_stats_update(SPI_SLAVE_RD, ret_trans->trans_len);
+
+            // hand the dma buffer over to the AT core without copying
+            desc->pos = 0;
+            desc->left_len = ret_trans->trans_len;
+            desc->next = NULL;
+            at_spi_mutex_lock();
+            if (!sp_rx_tail) {
+                sp_rx_head = desc;
+            } else {
+                sp_rx_tail->next = desc;
+            }
+            sp_rx_tail = desc;
+            s_spi_rx_pending_len += desc->left_len;
+            at_spi_mutex_unlock();
+
+            // notify at core to recv data
+            esp_at_port_recv_data_notify(ret_trans->trans_len, portMAX_DELAY);
+
+        } else if (trans_msg.direct == SPI_SLAVE_WR) {
+            // slave -> master
+            if (tx_len[tx_idx] == 0) {
+                tx_len[tx_idx] = xStreamBufferReceive(s_spi_slave_tx_ring_buf, (void *)tx_buffer[tx_idx], s_spi_tx_trans_size, 0);
+            }
+            if (tx_len[tx_idx] == 0) {
+                ESP_LOGD(TAG, "receive send queue but no data");
+                at_spi_mutex_lock();
+                if (xStreamBufferBytesAvailable(s_spi_slave_tx_ring_buf) > 0) {
+                    spi_msg_t spi_msg = {
+                        .direct = SPI_SLAVE_WR,
+                    };
+                    xQueueSend(s_spi_msg_queue, (void *)&spi_msg, 0);
+                } else {
+                    s_init_tx_flag = 0;
+                }
+                at_spi_mutex_unlock();
+                continue;
+            }
+            at_spi_write_transmit_len(SPI_SLAVE_WR, tx_len[tx_idx]);
+
+            slave_trans.data = tx_buffer[tx_idx];
+            slave_trans.len = tx_len[tx_idx];
+            ESP_ERROR_CHECK(spi_slave_hd_queue_trans(SPI2_HOST, SPI_SLAVE_CHAN_TX, &slave_trans, portMAX_DELAY));
+
+            // slave send done and notify master to recv
+            gpio_set_level(CONFIG_SPI_HANDSHAKE_PIN, 1);
+
+            // prefetch the next buffer while the master is reading the current one
+            uint8_t next_idx = tx_idx ^ 1;
+            tx_len[next_idx] = xStreamBufferReceive(s_spi_slave_tx_ring_buf, (void *)tx_buffer[next_idx], s_spi_tx_trans_size, 0);
+
+            ESP_ERROR_CHECK(spi_slave_hd_get_trans_res(SPI2_HOST, SPI_SLAVE_CHAN_TX, &ret_trans, portMAX_DELAY));
+            at_spi_stats_update(SPI_SLAVE_WR, tx_len[tx_idx]);
+            tx_len[tx_idx] = 0;
+            tx_idx = next_idx;
+
+            at_spi_mutex_lock();
+            if (tx_len[tx_idx] > 0 || xStreamBufferBytesAvailable(s_spi_slave_tx_ring_buf) > 0) {
+                spi_msg_t spi_msg = {
+                    .direct = SPI_SLAVE_WR,
+                };
+                if (xQueueSend(s_spi_msg_queue, (void *)&spi_msg, 0) != pdPASS) {
+                    ESP_LOGE(TAG, "send to msg queue error");
+                }
+            } else {
+                s_init_tx_flag = 0;
+            }
+            at_spi_mutex_unlock();
+
+        } else {
+            ESP_LOGE(TAG, "unknown direct: %d", trans_msg.direct);
+            continue;
+        }
+    }
+
+    vTaskDelete(NULL);
+}
+#else
+
 static void at_spi_task(void *params)
 {
     uint8_t *buffer = (uint8_t *)malloc(AT_SPI_DMA_SIZE * sizeof(uint8_t));
@@ -172,9 +466,7 @@ static void at_spi_task(void *params)
 
     spi_slave_hd_data_t *ret_trans;
     while (1) {
-        memset(buffer, 0x0, AT_SPI_DMA_SIZE);
         spi_msg_t trans_msg = {0};
-        memset(&trans_msg, 0x0, sizeof(spi_msg_t));
 
         // set handshake pin to low level
         gpio_set_level(CONFIG_SPI_HANDSHAKE_PIN, 0);
@@ -186,11 +478,15 @@ static void at_spi_task(void *params)
 
         if (trans_msg.direct == SPI_SLAVE_RD) {
             // master -> slave
+            if (at_spi_nego_check()) {
+                continue;
+            }
+
             // tell master transmit mode is master send
-            at_spi_write_transmit_len(SPI_SLAVE_RD, AT_SPI_DMA_SIZE);
+            at_spi_write_transmit_len(SPI_SLAVE_RD, AT_SPI_RX_TRANS_SIZE_MAX);
 
             slave_trans.data = buffer;
-            slave_trans.len = AT_SPI_DMA_SIZE;
+            slave_trans.len = AT_SPI_RX_TRANS_SIZE_MAX;
             ESP_ERROR_CHECK(spi_slave_hd_queue_trans(SPI2_HOST, SPI_SLAVE_CHAN_RX, &slave_trans, portMAX_DELAY));
 
             // slave has rx done, notify master to do next translation
@@ -203,6 +499,7 @@ static void at_spi_task(void *params)
             }
 
             xStreamBufferSend(s_spi_slave_rx_ring_buf, (void *)buffer, ret_trans->trans_len, portMAX_DELAY);
+            at_spi_stats_update(SPI_SLAVE_RD, ret_trans->trans_len);
 
             // notify at core to recv data
             esp_at_port_recv_data_notify(ret_trans->trans_len, portMAX_DELAY);
@@ -212,7 +509,7 @@ static void at_spi_task(void *params)
             uint32_t to_send_len = 0;
             uint32_t remain_len = xStreamBufferBytesAvailable(s_spi_slave_tx_ring_buf);
             if (remain_len > 0) {
-                to_send_len = remain_len > AT_SPI_DMA_SIZE ? AT_SPI_DMA_SIZE : remain_len;
+                to_send_len = remain_len > s_spi_tx_trans_size ? s_spi_tx_trans_size : remain_len;
                 at_spi_write_transmit_len(SPI_SLAVE_WR, to_send_len);
             } else {
                 ESP_LOGD(TAG, "receive send queue but no data");
@@ -232,6 +529,7 @@ static void at_spi_task(void *params)
             gpio_set_level(CONFIG_SPI_HANDSHAKE_PIN, 1);
 
             ESP_ERROR_CHECK(spi_slave_hd_get_trans_res(SPI2_HOST, SPI_SLAVE_CHAN_TX, &ret_trans, portMAX_DELAY));
+            at_spi_stats_update(SPI_SLAVE_WR, to_send_len);
 
             at_spi_mutex_lock();
             remain_len = xStreamBufferBytesAvailable(s_spi_slave_tx_ring_buf);
@@ -257,6 +555,7 @@ static void at_spi_task(void *params)
     free(buffer);
     vTaskDelete(NULL);
 }
+#endif
 
 static void at_spi_bus_default_config(spi_bus_config_t *bus_cfg)
 {
@@ -286,7 +585,7 @@ static void at_spi_slot_default_config(spi_slave_hd_slot_config_t *slave_hd_cfg)
     slave_hd_cfg->command_bits = 8;
     slave_hd_cfg->address_bits = 8;
     slave_hd_cfg->dummy_bits = 8;
-    slave_hd_cfg->queue_size = 4;
+    slave_hd_cfg->queue_size = 4;     // must not be less than CONFIG_AT_SPI_PIPELINE_DESC_NUM
     slave_hd_cfg->dma_chan = SPI_DMA_CH_AUTO;
 
     // master writes to shared buffer
@@ -310,9 +609,15 @@ static void at_spi_init(void)
     // init ring buffer, queue, and mutex
     s_spi_rw_sema = xSemaphoreCreateMutex();
     s_spi_msg_queue = xQueueCreate(10, sizeof(spi_msg_t));
-    s_spi_slave_rx_ring_buf = xStreamBufferCreate(CONFIG_RX_STREAM_BUFFER_SIZE, 1024);
     s_spi_slave_tx_ring_buf = xStreamBufferCreate(CONFIG_TX_STREAM_BUFFER_SIZE, 1024);
+#ifdef CONFIG_AT_SPI_PIPELINE_MODE
+    // the received data stays in the rx dma buffers until the AT core reads it, no rx stream buffer is needed
+    s_spi_rx_desc_sema = xSemaphoreCreateCounting(CONFIG_AT_SPI_PIPELINE_DESC_NUM, CONFIG_AT_SPI_PIPELINE_DESC_NUM);
+    if (!s_spi_rw_sema || !s_spi_msg_queue || !s_spi_rx_desc_sema || !s_spi_slave_tx_ring_buf) {
+#else
+    s_spi_slave_rx_ring_buf = xStreamBufferCreate(CONFIG_RX_STREAM_BUFFER_SIZE, 1024);
     if (!s_spi_rw_sema || !s_spi_msg_queue || !s_spi_slave_rx_ring_buf || !s_spi_slave_tx_ring_buf) {
+#endif
         ESP_LOGE(TAG, "create StreamBuffer error, free heap heap: %d", esp_get_free_heap_size());
         return;
     }
@@ -332,6 +637,24 @@ static void at_spi_init(void)
     ESP_LOGI(TAG, "init spi");
     init_slave_hd();
 
+    // publish the maximum transaction length of the slave before any transaction
+    at_spi_write_transmit_len(SPI_NULL, 0);
+
+#ifdef CONFIG_AT_SPI_PIPELINE_MODE
+    // queue all the rx descriptors in advance
+    for (int i = 0; i < CONFIG_AT_SPI_PIPELINE_DESC_NUM; ++i) {
+        at_spi_rx_desc_t *desc = &s_spi_rx_desc[i];
+        desc->trans.data = heap_caps_malloc(AT_SPI_DMA_SIZE, MALLOC_CAP_DMA);
+        if (desc->trans.data == NULL) {
+            ESP_LOGE(TAG, "malloc rx dma buffer failed");
+            return;
+        }
+        desc->trans.len = AT_SPI_DMA_SIZE;
+        desc->trans.arg = desc;
+        ESP_ERROR_CHECK(spi_slave_hd_queue_trans(SPI2_HOST, SPI_SLAVE_CHAN_RX, &desc->trans, portMAX_DELAY));
+    }
+#endif
+
     // init spi slave task
     xTaskCreate(at_spi_task, "at_spi_task", 4096, NULL, 10, &s_task_handle);
 }
@@ -356,7 +679,8 @@ void at_interface_init(void)
         .read_data = at_spi_read_data,
         .write_data = at_spi_write_data,
         .get_data_length = at_spi_get_data_len,
-        .wait_write_complete = NULL
+        .wait_write_complete = NULL,
+        .writev_data = at_spi_writev_data,
     };
     at_interface_ops_init(&spi_ops);
 
@@ -23,6 +23,12 @@
 
 // static variables
 static const uint8_t g_at_uart_parity_table[] = {UART_PARITY_DISABLE, UART_PARITY_ODD, UART_PARITY_EVEN};
+static at_uart_rx_config_t s_at_uart_rx_config = {
+    .rxfifo_full_thresh = AT_UART_RXFIFO_FULL_THRESH_DEF,
+    .rx_timeout_thresh = AT_UART_RX_TIMEOUT_THRESH_DEF,
+    .window_ms = 0,
+    .window_bytes = 0,
+};
 static const char *TAG = "at-uart";
 
 // global variables
@@ -233,18 +239,44 @@ esp_err_t at_mfg_uart_port_pins_get(at_uart_port_pins_t *config)
     return ESP_OK;
 }
 
-void at_uart_intr_config(void)
+esp_err_t at_uart_intr_config(void)
 {
     uart_intr_config_t intr_config = {
         .intr_enable_mask = UART_RXFIFO_FULL_INT_ENA_M
         | UART_RXFIFO_TOUT_INT_ENA_M
         | UART_RXFIFO_OVF_INT_ENA_M,
-        .rxfifo_full_thresh = 100,
-        .rx_timeout_thresh = 10,
+        .rxfifo_full_thresh = s_at_uart_rx_config.rxfifo_full_thresh,
+        .rx_timeout_thresh = s_at_uart_rx_config.rx_timeout_thresh,
         .txfifo_empty_intr_thresh = 10
     };
 
-    uart_intr_config(g_at_cmd_port, &intr_config);
+    return uart_intr_config(g_at_cmd_port, &intr_config);
+}
+
+void at_uart_rx_config_get(at_uart_rx_config_t *config)
+{
+    memcpy(config, &s_at_uart_rx_config, sizeof(at_uart_rx_config_t));
+}
+
+esp_err_t at_uart_rx_config_set(const at_uart_rx_config_t *config)
+{
+    if (config->rxfifo_full_thresh == 0 || config->rxfifo_full_thresh >= SOC_UART_FIFO_LEN
+            || config->rx_timeout_thresh == 0 || config->window_ms > AT_UART_RX_WINDOW_MS_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    at_uart_rx_config_t old_config;
+    memcpy(&old_config, &s_at_uart_rx_config, sizeof(at_uart_rx_config_t));
+    memcpy(&s_at_uart_rx_config, config, sizeof(at_uart_rx_config_t));
+
+    esp_err_t ret = at_uart_intr_config();
+    if (ret != ESP_OK) {
+        ESP_AT_LOGE(TAG, "uart intr config failed:0x%x", ret);
+        memcpy(&s_at_uart_rx_config, &old_config, sizeof(at_uart_rx_config_t));
+        at_uart_intr_config();
+    }
+
+    return ret;
 }
 
 #if !defined(CONFIG_IDF_TARGET_ESP32C5) && !defined(CONFIG_IDF_TARGET_ESP32C61)
@@ -13,6 +13,8 @@
 #include "soc/gpio_periph.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
 #include "esp_at.h"
 #include "nvs.h"
 #include "nvs_flash.h"
@@ -26,6 +28,13 @@
 // static variables
 static QueueHandle_t s_at_uart_queue = NULL;
 static TaskHandle_t s_task_handle = NULL;
+static SemaphoreHandle_t s_at_uart_tx_mutex = NULL;
+static uint8_t s_at_uart_discard_buf[AT_UART_DISCARD_BUFFER_SIZE];   // the content is never used, so it can be shared by all the readers
+static at_uart_rx_stats_t s_at_uart_rx_stats;
+static portMUX_TYPE s_at_uart_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+#ifdef CONFIG_AT_UART_HEAP_ALLOC_COUNTER
+static TaskHandle_t s_at_uart_reader = NULL;                        // the task which is inside at_uart_read_data(), accessed atomically
+#endif
 static const char *TAG = "at-uart";
 
 // global variables
@@ -36,40 +45,121 @@ static int32_t at_uart_write_data(uint8_t *data, int32_t len)
 {
     uint32_t length = 0;
 
+    xSemaphoreTake(s_at_uart_tx_mutex, portMAX_DELAY);
     length = uart_write_bytes(g_at_cmd_port, (char *)data, len);
+    xSemaphoreGive(s_at_uart_tx_mutex);
     return length;
 }
 
+static int32_t at_uart_writev_data(const esp_at_iovec_t *iov, int32_t iovcnt)
+{
+    int32_t length = 0;
+
+    // hold the tx mutex across the segments, so that no other writer can be interleaved
+    xSemaphoreTake(s_at_uart_tx_mutex, portMAX_DELAY);
+    for (int32_t i = 0; i < iovcnt; ++i) {
+        if (iov[i].len <= 0) {
+            continue;
+        }
+        int ret = uart_write_bytes(g_at_cmd_port, (const char *)iov[i].data, iov[i].len);
+        if (ret < 0) {
+            break;
+        }
+        length += ret;
+    }
+    xSemaphoreGive(s_at_uart_tx_mutex);
+
+    return length;
+}
+
+void at_uart_rx_stats_get(at_uart_rx_stats_t *stats)
+{
+    portENTER_CRITICAL(&s_at_uart_stats_lock);
+    memcpy(stats, &s_at_uart_rx_stats, sizeof(at_uart_rx_stats_t));
+    portEXIT_CRITICAL(&s_at_uart_stats_lock);
+}
+
+#ifdef CONFIG_AT_UART_HEAP_ALLOC_COUNTER
+/**
+ * The heap component calls this hook after every successful allocation (CONFIG_HEAP_USE_HOOKS).
+ * Only the allocations from the uart task and from the AT core inside at_uart_read_data() are counted.
+*/
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    if (xPortInIsrContext()) {
+        return;
+    }
+
+    // the hook runs on any task, while the reader is set and cleared by the AT core
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    if (task != s_task_handle && task != __atomic_load_n(&s_at_uart_reader, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_at_uart_stats_lock);
+    s_at_uart_rx_stats.heap_alloc_num++;
+    portEXIT_CRITICAL(&s_at_uart_stats_lock);
+}
+#endif
+
+/**
+ * Drop the received data from the uart driver through a static scratch buffer, without any heap allocation.
+*/
+static int32_t at_uart_discard_data(int32_t len, TickType_t ticks_to_wait)
+{
+    int32_t discard_len = 0;
+
+    while (discard_len < len) {
+        int32_t chunk_len = at_min(len - discard_len, AT_UART_DISCARD_BUFFER_SIZE);
+        int ret = uart_read_bytes(g_at_cmd_port, s_at_uart_discard_buf, chunk_len, ticks_to_wait);
+        if (ret < 0) {
+            return discard_len ? discard_len : -1;
+        }
+        discard_len += ret;
+        if (ret < chunk_len) {
+            break;
+        }
+    }
+
+    portENTER_CRITICAL(&s_at_uart_stats_lock);
+    s_at_uart_rx_stats.discard_bytes += discard_len;
+    portEXIT_CRITICAL(&s_at_uart_stats_lock);
+
+    return discard_len;
+}
+
 static int32_t at_uart_read_data(uint8_t *buffer, int32_t len)
 {
+    int32_t ret = 0;
+
     if (len == 0) {
         return 0;
     }
 
+#ifdef CONFIG_AT_UART_HEAP_ALLOC_COUNTER
+    __atomic_store_n(&s_at_uart_reader, xTaskGetCurrentTaskHandle(), __ATOMIC_RELAXED);
+#endif
+
     if (buffer == NULL) {
         if (len == -1) {
             size_t size = 0;
             if (uart_get_buffered_data_len(g_at_cmd_port, &size) != ESP_OK) {
-                return -1;
+                ret = -1;
+                goto exit;
             }
             len = size;
         }
 
-        if (len == 0) {
-            return 0;
-        }
-
-        uint8_t *data = (uint8_t *)malloc(len);
-        if (data) {
-            len = uart_read_bytes(g_at_cmd_port, data, len, portTICK_PERIOD_MS);
-            free(data);
-            return len;
-        } else {
-            return -1;
-        }
+        ret = (len == 0) ? 0 : at_uart_discard_data(len, portTICK_PERIOD_MS);
     } else {
-        return uart_read_bytes(g_at_cmd_port, buffer, len, portTICK_PERIOD_MS);
+        ret = uart_read_bytes(g_at_cmd_port, buffer, len, portTICK_PERIOD_MS);
     }
+
+exit:
+#ifdef CONFIG_AT_UART_HEAP_ALLOC_COUNTER
+    __atomic_store_n(&s_at_uart_reader, NULL, __ATOMIC_RELAXED);
+#endif
+    return ret;
 }
 
 static int32_t at_uart_get_data_len(void)
@@ -100,8 +190,9 @@ static void at_uart_task(void *params)
     uart_event_t event;
     int pattern_pos = -1;
     BaseType_t retry_flag = pdFALSE;
-    uint8_t *data = NULL;
     uint32_t data_len = 0;
+    at_uart_rx_config_t rx_config;
+    TickType_t window_start = 0, window_ticks = 0;
 
     // wait for AT ready
     ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
@@ -115,7 +206,21 @@ retry:
                 data_len += event.size;
                 // we can put all data together to process
                 retry_flag = pdFALSE;
-                while (xQueueReceive(s_at_uart_queue, (void *)&event, 0) == pdTRUE) {
+                at_uart_rx_config_get(&rx_config);
+                window_start = xTaskGetTickCount();
+                window_ticks = pdMS_TO_TICKS(rx_config.window_ms);
+                for (;;) {
+                    // keep waiting for the following events only while the data keeps streaming in,
+                    // a short rx event means the rx line is idle, so notify the AT core at once
+                    TickType_t wait_ticks = 0;
+                    if (event.type == UART_DATA && event.size >= rx_config.rxfifo_full_thresh
+                            && (rx_config.window_bytes == 0 || data_len < rx_config.window_bytes)) {
+                        TickType_t elapsed_ticks = xTaskGetTickCount() - window_start;
+                        wait_ticks = (elapsed_ticks < window_ticks) ? (window_ticks - elapsed_ticks) : 0;
+                    }
+                    if (xQueueReceive(s_at_uart_queue, (void *)&event, wait_ticks) != pdTRUE) {
+                        break;
+                    }
                     if (event.type == UART_DATA) {
                         data_len += event.size;
                     } else if (event.type == UART_BUFFER_FULL) {
@@ -138,10 +243,8 @@ retry:
             case UART_PATTERN_DET:
                 pattern_pos = uart_pattern_pop_pos(g_at_cmd_port);
                 if (pattern_pos >= 0) {
-                    data = (uint8_t *)malloc(pattern_pos + 3);
-                    uart_read_bytes(g_at_cmd_port, data, pattern_pos + 3, 0);
-                    free(data);
-                    data = NULL;
+                    // drop the data before the pattern and the "+++" itself
+                    at_uart_discard_data(pattern_pos + 3, 0);
                 } else {
                     uart_flush_input(g_at_cmd_port);
                     xQueueReset(s_at_uart_queue);
@@ -182,6 +285,11 @@ static void at_uart_init(void)
 
     // install uart driver
     uart_driver_install(g_at_cmd_port, AT_UART_RX_BUFFER_SIZE, AT_UART_TX_BUFFER_SIZE, AT_UART_QUEUE_SIZE, &s_at_uart_queue, 0);
+    s_at_uart_tx_mutex = xSemaphoreCreateMutex();
+    if (!s_at_uart_tx_mutex) {
+        ESP_LOGE(TAG, "create uart tx mutex failed");
+        abort();
+    }
 
     // set uart configuration
     uart_config_t config;
@@ -283,6 +391,7 @@ void at_interface_init(void)
         .write_data = at_uart_write_data,
         .get_data_length = at_uart_get_data_len,
         .wait_write_complete = at_uart_wait_tx_done,
+        .writev_data = at_uart_writev_data,
     };
     at_interface_ops_init(&uart_ops);
 
@@ -0,0 +1,67 @@
+#!/usr/bin/env python
+#
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: Apache-2.0
+
+"""
+Compare the AT boot profiler reports (CONFIG_AT_BOOT_PROFILER) of two builds.
+
+Capture the log port output of each build until "ready", then:
+    python at_boot_prof_diff.py <old_build.log> <new_build.log>
+"""
+
+import argparse
+import sys
+
+PREFIX = 'AT_BOOT_PROF,'
+
+
+def load(path):
+    """
+    Return the {phase: cost_us} of the last report in the log, and the phase order.
+    """
+    phases = {}
+    order = []
+    with open(path, 'r', errors='ignore') as f:
+        for line in f:
+            pos = line.find(PREFIX)
+            if pos < 0:
+                continue
+            fields = line[pos + len(PREFIX):].strip().rsplit(',', 2)
+            if len(fields) != 3:
+                continue
+            phase, _, cost = fields
+            if order and phase == order[0]:
+                # a new report starts, e.g., the log contains several boots
+                phases = {}
+                order = []
+            phases[phase] = int(cost)
+            order.append(phase)
+    return phases, order
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare the AT boot profiler reports of two builds')
+    parser.add_argument('old', help='the log of the old build')
+    parser.add_argument('new', help='the log of the new build')
+    args = parser.parse_args()
+
+    old, old_order = load(args.old)
+    new, new_order = load(args.new)
+    if not old or not new:
+        sys.stderr.write('No AT_BOOT_PROF lines found, please enable CONFIG_AT_BOOT_PROFILER\n')
+        return 1
+
+    phases = old_order + [p for p in new_order if p not in old]
+    print('{:<40} {:>10} {:>10} {:>10}'.format('phase', 'old(us)', 'new(us)', 'delta(us)'))
+    for phase in sorted(phases, key=lambda p: abs(new.get(p, 0) - old.get(p, 0)), reverse=True):
+        print('{:<40} {:>10} {:>10} {:>+10}'.format(phase, old.get(phase, '-'), new.get(phase, '-'),
+                                                    new.get(phase, 0) - old.get(phase, 0)))
+    old_total = sum(old.values())
+    new_total = sum(new.values())
+    print('{:<40} {:>10} {:>10} {:>+10}'.format('total', old_total, new_total, new_total - old_total))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,152 @@
+#!/usr/bin/env python
+#
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: Apache-2.0
+
+"""
+Generate a delta image for AT+USEROTA=<url_len>,1 (CONFIG_AT_DELTA_OTA_SUPPORT).
+
+The delta image rebuilds the new firmware from the firmware running on the module, see components/at/include/at_delta_ota.h.
+    python at_delta_gen.py <old_firmware.bin> <new_firmware.bin> -o <delta.bin>
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+
+DELTA_MAGIC = b'ATDP'
+DELTA_VERSION = 1
+HEADER = struct.Struct('<4sHHII16s16s')
+OP = struct.Struct('<BII')
+RECORD = struct.Struct('<HH')
+
+OP_COPY = 1
+OP_INSERT = 2
+OP_DIFF = 3
+
+BLOCK_SIZE = 16             # the minimum length of an exact match to start a copy
+INDEX_STEP = 4              # the old firmware is indexed every INDEX_STEP bytes
+FUZZY_WINDOW = 64           # a diff op goes on while the last FUZZY_WINDOW bytes have at most FUZZY_MISMATCH_MAX mismatches
+FUZZY_MISMATCH_MAX = 16
+RECORD_LEN_MAX = 0xFFFF
+OP_LEN_MAX = 0xFFFFFFFF
+
+
+def build_index(old):
+    index = {}
+    for pos in range(0, len(old) - BLOCK_SIZE + 1, INDEX_STEP):
+        index.setdefault(old[pos:pos + BLOCK_SIZE], pos)
+    return index
+
+
+def extend_match(old, new, src, dst):
+    """
+    Extend a match forward, the mismatched bytes are allowed while the match is still good enough.
+    Return the length of the match, which ends with the last matched byte.
+    """
+    length = 0
+    last_good = 0
+    mismatches = []
+    while src + length < len(old) and dst + length < len(new):
+        if old[src + length] != new[dst + length]:
+            mismatches.append(length)
+            while mismatches and mismatches[0] <= length - FUZZY_WINDOW:
+                mismatches.pop(0)
+            if len(mismatches) > FUZZY_MISMATCH_MAX:
+                break
+        else:
+            last_good = length + 1
+        length += 1
+    return last_good
+
+
+def encode_diff(old, new, src, dst, length):
+    """
+    Encode new[dst:dst+length] against old[src:src+length] as the records of {same_len, diff_len, data}.
+    """
+    records = bytearray()
+    pos = 0
+    exact = True
+    while pos < length:
+        same = 0
+        while pos + same < length and same < RECORD_LEN_MAX and old[src + pos + same] == new[dst + pos + same]:
+            same += 1
+        pos += same
+        diff = 0
+        while pos + diff < length and diff < RECORD_LEN_MAX and old[src + pos + diff] != new[dst + pos + diff]:
+            diff += 1
+        if diff:
+            exact = False
+        records += RECORD.pack(same, diff)
+        records += new[dst + pos:dst + pos + diff]
+        pos += diff
+    return exact, bytes(records)
+
+
+def generate(old, new):
+    index = build_index(old)
+    ops = bytearray()
+    stats = {OP_COPY: 0, OP_INSERT: 0, OP_DIFF: 0}
+    literal_start = 0
+    dst = 0
+
+    def flush_literal(end):
+        pos = literal_start
+        while pos < end:
+            length = min(end - pos, OP_LEN_MAX)
+            ops.extend(OP.pack(OP_INSERT, length, 0))
+            ops.extend(new[pos:pos + length])
+            stats[OP_INSERT] += length
+            pos += length
+
+    while dst + BLOCK_SIZE <= len(new):
+        src = index.get(new[dst:dst + BLOCK_SIZE])
+        if src is None:
+            dst += 1
+            continue
+
+        length = extend_match(old, new, src, dst)
+        flush_literal(dst)
+        exact, records = encode_diff(old, new, src, dst, length)
+        if exact:
+            ops.extend(OP.pack(OP_COPY, length, src))
+            stats[OP_COPY] += length
+        else:
+            ops.extend(OP.pack(OP_DIFF, length, src))
+            ops.extend(records)
+            stats[OP_DIFF] += length
+        dst += length
+        literal_start = dst
+
+    flush_literal(len(new))
+
+    header = HEADER.pack(DELTA_MAGIC, DELTA_VERSION, HEADER.size, len(old), len(new),
+                         hashlib.md5(old).digest(), hashlib.md5(new).digest())
+    return header + bytes(ops), stats
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate a delta image for the AT Delta OTA')
+    parser.add_argument('old', help='the firmware running on the module')
+    parser.add_argument('new', help='the new firmware')
+    parser.add_argument('-o', '--output', required=True, help='the delta image to generate')
+    args = parser.parse_args()
+
+    with open(args.old, 'rb') as f:
+        old = f.read()
+    with open(args.new, 'rb') as f:
+        new = f.read()
+
+    delta, stats = generate(old, new)
+    with open(args.output, 'wb') as f:
+        f.write(delta)
+
+    print('old: {} bytes, new: {} bytes, delta: {} bytes ({:.1f}%)'.format(
+        len(old), len(new), len(delta), len(delta) * 100.0 / max(len(new), 1)))
+    print('copied: {} bytes, diffed: {} bytes, inserted: {} bytes'.format(stats[OP_COPY], stats[OP_DIFF], stats[OP_INSERT]))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "esp_idf_version.h"
+#include "esp_at.h"
+#include "at_uart.h"
+#include "driver/uart.h"
+#include "at_intf_bench.h"
+
+/**
+ * A stand-in of main/interface/uart/at_uart_api.c for the linux target.
+ *
+ * There is no manufacturing nvs partition and no gpio behind the pseudo-terminal, so only the uart configuration
+ * and the rx notification configuration are kept. The rx coalescing window is taken from AT_BENCH_RX_WINDOW_MS
+ * and AT_BENCH_RX_WINDOW_BYTES, in place of AT+UARTRXCFG.
+*/
+
+// static variables
+static at_uart_rx_config_t s_at_uart_rx_config = {
+    .rxfifo_full_thresh = AT_UART_RXFIFO_FULL_THRESH_DEF,
+    .rx_timeout_thresh = AT_UART_RX_TIMEOUT_THRESH_DEF,
+    .window_ms = AT_BENCH_RX_WINDOW_MS,
+    .window_bytes = AT_BENCH_RX_WINDOW_BYTES,
+};
+
+// global variables
+extern uint8_t g_at_cmd_port;
+
+esp_err_t at_mfg_uart_port_pins_get(at_uart_port_pins_t *config)
+{
+    config->number = UART_NUM_1;
+    config->tx_pin = UART_PIN_NO_CHANGE;
+    config->rx_pin = UART_PIN_NO_CHANGE;
+    config->cts_pin = UART_PIN_NO_CHANGE;
+    config->rts_pin = UART_PIN_NO_CHANGE;
+
+    return ESP_OK;
+}
+
+esp_err_t at_uart_intr_config(void)
+{
+    uart_intr_config_t intr_config = {
+        .rxfifo_full_thresh = s_at_uart_rx_config.rxfifo_full_thresh,
+        .rx_timeout_thresh = s_at_uart_rx_config.rx_timeout_thresh,
+        .txfifo_empty_intr_thresh = 10
+    };
+
+    return uart_intr_config(g_at_cmd_port, &intr_config);
+}
+
+void at_uart_rx_config_get(at_uart_rx_config_t *config)
+{
+    memcpy(config, &s_at_uart_rx_config, sizeof(at_uart_rx_config_t));
+}
+
+void at_uart_workaround(void)
+{
+}
+
+void at_uart_config_init(uart_config_t *config)
+{
+    memset(config, 0x0, sizeof(uart_config_t));
+    config->baud_rate = AT_UART_BAUD_RATE_DEF;
+    config->data_bits = UART_DATA_8_BITS;
+    config->parity = UART_PARITY_DISABLE;
+    config->stop_bits = UART_STOP_BITS_1;
+    config->flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+    config->rx_flow_ctrl_thresh = 122;
+    config->source_clk = UART_SCLK_DEFAULT;
+}
+
+void at_nvs_uart_config_set(uart_config_t *config)
+{
+}
+
+bool at_nvs_uart_config_get(uart_config_t *config)
+{
+    // keep the default configuration, there is no nvs partition
+    return true;
+}
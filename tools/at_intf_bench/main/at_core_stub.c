@@ -0,0 +1,139 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_at.h"
+#include "at_intf_bench.h"
+
+/**
+ * A minimal stand-in of the AT core library (libesp_at_core.a is not built for the linux target).
+ *
+ * It only implements the port-related APIs used by the interface layer, and consumes the received data
+ * in the same way as the AT core: wait for a notification, then drain the port through get_data_length and read_data.
+*/
+
+// static variables
+static esp_at_device_ops_struct s_device_ops;
+static esp_at_custom_ops_struct s_custom_ops;
+static QueueHandle_t s_notify_queue = NULL;
+static at_bench_core_stats_t s_core_stats;     // updated by the uart task and the emulated AT core, fetched by the bench, always accessed atomically
+static const char *TAG = "at-core-stub";
+
+void esp_at_device_ops_regist(esp_at_device_ops_struct *ops)
+{
+    memcpy(&s_device_ops, ops, sizeof(esp_at_device_ops_struct));
+}
+
+void esp_at_custom_ops_regist(esp_at_custom_ops_struct *ops)
+{
+    memcpy(&s_custom_ops, ops, sizeof(esp_at_custom_ops_struct));
+}
+
+bool esp_at_port_recv_data_notify(int32_t len, uint32_t msec)
+{
+    if (!s_notify_queue) {
+        return false;
+    }
+
+    __atomic_fetch_add(&s_core_stats.notifies, 1, __ATOMIC_RELAXED);
+    return xQueueSend(s_notify_queue, &len, msec == portMAX_DELAY ? portMAX_DELAY : pdMS_TO_TICKS(msec)) == pdTRUE;
+}
+
+int32_t esp_at_port_write_data(uint8_t *data, int32_t len)
+{
+    if (!s_device_ops.write_data) {
+        return -1;
+    }
+    return s_device_ops.write_data(data, len);
+}
+
+int32_t esp_at_port_read_data(uint8_t *data, int32_t len)
+{
+    if (!s_device_ops.read_data) {
+        return -1;
+    }
+    return s_device_ops.read_data(data, len);
+}
+
+int32_t esp_at_port_get_data_length(void)
+{
+    if (!s_device_ops.get_data_length) {
+        return -1;
+    }
+    return s_device_ops.get_data_length();
+}
+
+bool esp_at_port_wait_write_complete(int32_t timeout_msec)
+{
+    if (!s_device_ops.wait_write_complete) {
+        return true;
+    }
+    return s_device_ops.wait_write_complete(timeout_msec);
+}
+
+void esp_at_transmit_terminal(void)
+{
+    // the "+++" pattern is not emulated by the pseudo-terminal uart driver
+}
+
+void esp_at_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    if (CONFIG_AT_LOG_DEFAULT_LEVEL >= level) {
+        va_list list;
+        va_start(list, format);
+        esp_log_writev(level, tag, format, list);
+        va_end(list);
+        esp_log_write(level, tag, "\n");
+    }
+}
+
+static void at_core_stub_task(void *params)
+{
+    static uint8_t s_buffer[AT_BENCH_CORE_READ_BUFFER_SIZE];
+    int32_t notify_len = 0;
+    uint64_t total_len = 0;
+
+    for (;;) {
+        xQueueReceive(s_notify_queue, &notify_len, portMAX_DELAY);
+
+        // drain everything available, the same as the AT core does for a passthrough link
+        int32_t data_len = esp_at_port_get_data_length();
+        while (data_len > 0) {
+            int32_t len = esp_at_port_read_data(s_buffer, at_min(data_len, AT_BENCH_CORE_READ_BUFFER_SIZE));
+            if (len <= 0) {
+                break;
+            }
+            __atomic_fetch_add(&s_core_stats.reads, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&s_core_stats.rx_bytes, len, __ATOMIC_RELAXED);
+            total_len += len;
+            data_len -= len;
+        }
+        at_bench_latency_mark_received(total_len);
+    }
+}
+
+void at_bench_core_start(void)
+{
+    s_notify_queue = xQueueCreate(64, sizeof(int32_t));
+    if (!s_notify_queue) {
+        ESP_LOGE(TAG, "create notify queue failed");
+        return;
+    }
+
+    xTaskCreate(at_core_stub_task, "atCore", 4096, NULL, 3, NULL);
+}
+
+void at_bench_core_stats_fetch(at_bench_core_stats_t *stats)
+{
+    stats->notifies = __atomic_exchange_n(&s_core_stats.notifies, 0, __ATOMIC_RELAXED);
+    stats->reads = __atomic_exchange_n(&s_core_stats.reads, 0, __ATOMIC_RELAXED);
+    stats->rx_bytes = __atomic_exchange_n(&s_core_stats.rx_bytes, 0, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,87 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef AT_BENCH_RX_WINDOW_MS
+#define AT_BENCH_RX_WINDOW_MS                   0       /**< rx coalescing time window, see at_uart_rx_config_t and AT+UARTRXCFG */
+#endif
+#ifndef AT_BENCH_RX_WINDOW_BYTES
+#define AT_BENCH_RX_WINDOW_BYTES                0       /**< rx coalescing byte window, see at_uart_rx_config_t and AT+UARTRXCFG */
+#endif
+#define AT_BENCH_CORE_READ_BUFFER_SIZE          1024    /**< buffer size used by the emulated AT core to read the AT port */
+#define AT_BENCH_LATENCY_SAMPLES_MAX            (64 * 1024)
+
+/**
+ * @brief The statistics of the emulated uart driver
+ *
+ * @note The counters are updated and fetched with atomic operations, since the driver task and the bench run concurrently.
+*/
+typedef struct {
+    uint32_t rx_events;         /**< the number of emulated UART_DATA events */
+    uint32_t rx_full_events;    /**< the number of emulated UART_BUFFER_FULL events */
+    uint64_t rx_bytes;          /**< the bytes moved from the pseudo-terminal into the driver rx buffer */
+} at_bench_uart_stats_t;
+
+/**
+ * @brief The statistics of the emulated AT core
+ *
+ * @note The counters are updated and fetched with atomic operations, since the uart task, the emulated AT core and the bench run concurrently.
+*/
+typedef struct {
+    uint32_t notifies;          /**< the number of esp_at_port_recv_data_notify() calls */
+    uint32_t reads;             /**< the number of read_data() calls from the AT core */
+    uint64_t rx_bytes;          /**< the bytes read by the AT core */
+} at_bench_core_stats_t;
+
+/**
+ * @brief Get the master side of the pseudo-terminal, the host traffic is written into it.
+ *
+ * @return the file descriptor of the pseudo-terminal master, or -1 if the interface is not initialized
+*/
+int at_bench_pty_master_fd(void);
+
+/**
+ * @brief Get and reset the statistics of the emulated uart driver
+ *
+ * @param[out] stats: The pointer of at_bench_uart_stats_t
+*/
+void at_bench_uart_stats_fetch(at_bench_uart_stats_t *stats);
+
+/**
+ * @brief Start the emulated AT core, which consumes esp_at_port_recv_data_notify() like the AT library does.
+*/
+void at_bench_core_start(void);
+
+/**
+ * @brief Get and reset the statistics of the emulated AT core
+ *
+ * @param[out] stats: The pointer of at_bench_core_stats_t
+*/
+void at_bench_core_stats_fetch(at_bench_core_stats_t *stats);
+
+/**
+ * @brief Record that the host has written the AT port stream up to the given offset.
+ *
+ * @note It is called from the host traffic thread (not a FreeRTOS task).
+ *
+ * @param[in] end_offset: The total bytes written by the host after this write
+*/
+void at_bench_latency_mark_written(uint64_t end_offset);
+
+/**
+ * @brief Record that the AT core has read the AT port stream up to the given offset.
+ *
+ * @param[in] total_offset: The total bytes read by the AT core
+*/
+void at_bench_latency_mark_received(uint64_t total_offset);
+
+/**
+ * @brief Get the monotonic time in microseconds
+*/
+uint64_t at_bench_time_us(void);
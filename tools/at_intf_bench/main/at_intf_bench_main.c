@@ -0,0 +1,232 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_at.h"
+#include "esp_at_interface.h"
+#include "at_intf_bench.h"
+
+#define AT_BENCH_DRAIN_TIMEOUT_MS       (10 * 1000)
+
+/**
+ * The scripted host traffic: the host writes <chunk_size> bytes into the AT port,
+ * sleeps <gap_us> microseconds, and repeats until <total_size> bytes have been written.
+*/
+typedef struct {
+    const char *name;
+    uint32_t chunk_size;
+    uint32_t gap_us;
+    uint32_t total_size;
+} at_bench_scenario_t;
+
+static const at_bench_scenario_t s_scenarios[] = {
+    {"at-cmd",           16,     2000,   32 * 1024},         // short AT commands typed by a host MCU
+    {"small-burst",      64,     100,    512 * 1024},        // small passthrough packets
+    {"passthrough-1k",   1024,   0,      4 * 1024 * 1024},   // bulk passthrough with 1 KB writes
+    {"passthrough-4k",   4096,   0,      8 * 1024 * 1024},   // bulk passthrough with 4 KB writes
+};
+
+typedef struct {
+    const at_bench_scenario_t *scenario;
+    uint64_t start_offset;
+} at_bench_traffic_t;
+
+// latency records, the writer is the host traffic thread, the reader is the emulated AT core,
+// s_written_num and s_received_num publish the records to the other side, so they are always accessed atomically
+static uint64_t s_written_offset[AT_BENCH_LATENCY_SAMPLES_MAX];
+static uint64_t s_written_time_us[AT_BENCH_LATENCY_SAMPLES_MAX];
+static uint32_t s_latency_us[AT_BENCH_LATENCY_SAMPLES_MAX];
+static uint32_t s_written_num = 0;
+static uint32_t s_received_num = 0;
+static uint64_t s_total_written = 0;
+static const char *TAG = "at-bench";
+
+uint64_t at_bench_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void at_bench_latency_mark_written(uint64_t end_offset)
+{
+    uint32_t num = __atomic_load_n(&s_written_num, __ATOMIC_RELAXED);
+    if (num >= AT_BENCH_LATENCY_SAMPLES_MAX) {
+        return;
+    }
+
+    s_written_offset[num] = end_offset;
+    s_written_time_us[num] = at_bench_time_us();
+    __atomic_store_n(&s_written_num, num + 1, __ATOMIC_RELEASE);
+}
+
+void at_bench_latency_mark_received(uint64_t total_offset)
+{
+    uint32_t written_num = __atomic_load_n(&s_written_num, __ATOMIC_ACQUIRE);
+    uint64_t now = at_bench_time_us();
+
+    uint32_t received_num = __atomic_load_n(&s_received_num, __ATOMIC_RELAXED);
+
+    while (received_num < written_num && s_written_offset[received_num] <= total_offset) {
+        s_latency_us[received_num] = now - s_written_time_us[received_num];
+        received_num++;
+    }
+    __atomic_store_n(&s_received_num, received_num, __ATOMIC_RELEASE);
+}
+
+static void *at_bench_traffic_thread(void *arg)
+{
+    at_bench_traffic_t *traffic = (at_bench_traffic_t *)arg;
+    const at_bench_scenario_t *scenario = traffic->scenario;
+    int fd = at_bench_pty_master_fd();
+
+    uint8_t *chunk = malloc(scenario->chunk_size);
+    if (!chunk) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < scenario->chunk_size; ++i) {
+        chunk[i] = 'a' + (i % 26);
+    }
+
+    uint64_t offset = traffic->start_offset;
+    uint32_t had_written_len = 0;
+    while (had_written_len < scenario->total_size) {
+        uint32_t to_write_len = at_min(scenario->chunk_size, scenario->total_size - had_written_len);
+        uint32_t pos = 0;
+        while (pos < to_write_len) {
+            ssize_t ret = write(fd, chunk + pos, to_write_len - pos);
+            if (ret > 0) {
+                pos += ret;
+            } else if (ret < 0 && errno != EAGAIN && errno != EINTR) {
+                free(chunk);
+                return NULL;
+            }
+        }
+        had_written_len += to_write_len;
+        offset += to_write_len;
+        at_bench_latency_mark_written(offset);
+
+        if (scenario->gap_us) {
+            usleep(scenario->gap_us);
+        }
+    }
+
+    free(chunk);
+    return NULL;
+}
+
+static int at_bench_latency_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t at_bench_percentile(uint32_t *sorted, uint32_t num, uint32_t percent)
+{
+    if (num == 0) {
+        return 0;
+    }
+    uint32_t index = (uint64_t)num * percent / 100;
+    return sorted[index >= num ? num - 1 : index];
+}
+
+/**
+ * @return false if the AT core has not received all the data before the deadline
+*/
+static bool at_bench_run(const at_bench_scenario_t *scenario)
+{
+    at_bench_uart_stats_t uart_stats;
+    at_bench_core_stats_t core_stats;
+
+    // reset statistics
+    at_bench_uart_stats_fetch(&uart_stats);
+    at_bench_core_stats_fetch(&core_stats);
+    __atomic_store_n(&s_written_num, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&s_received_num, 0, __ATOMIC_RELEASE);
+
+    at_bench_traffic_t traffic = {
+        .scenario = scenario,
+        .start_offset = s_total_written,
+    };
+
+    uint64_t start_us = at_bench_time_us();
+    pthread_t thread;
+    pthread_create(&thread, NULL, at_bench_traffic_thread, &traffic);
+
+    // wait for the AT core to receive all the data
+    uint64_t received_len = 0;
+    uint64_t deadline_us = start_us + (uint64_t)AT_BENCH_DRAIN_TIMEOUT_MS * 1000 + (uint64_t)scenario->total_size / scenario->chunk_size * scenario->gap_us;
+    while (received_len < scenario->total_size && at_bench_time_us() < deadline_us) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        at_bench_core_stats_t partial;
+        at_bench_core_stats_fetch(&partial);
+        core_stats.notifies += partial.notifies;
+        core_stats.reads += partial.reads;
+        core_stats.rx_bytes += partial.rx_bytes;
+        received_len = core_stats.rx_bytes;
+    }
+    uint64_t elapsed_us = at_bench_time_us() - start_us;
+    pthread_join(thread, NULL);
+
+    at_bench_uart_stats_fetch(&uart_stats);
+    bool completed = (received_len >= scenario->total_size);
+    if (completed) {
+        s_total_written += scenario->total_size;
+    } else {
+        // the stream offsets of the host and the AT core no longer match, the latency of the later scenarios would be wrong
+        ESP_LOGE(TAG, "%s: only %llu of %u bytes were received", scenario->name, received_len, scenario->total_size);
+    }
+
+    uint32_t samples = __atomic_load_n(&s_received_num, __ATOMIC_ACQUIRE);
+    qsort(s_latency_us, samples, sizeof(uint32_t), at_bench_latency_cmp);
+
+    printf("%-16s %10.1f %8u %8u %8u %8u %8u %8u %8u %8.2f\n",
+           scenario->name,
+           (double)received_len * 1000000 / (elapsed_us ? elapsed_us : 1),
+           samples,
+           at_bench_percentile(s_latency_us, samples, 50),
+           at_bench_percentile(s_latency_us, samples, 90),
+           at_bench_percentile(s_latency_us, samples, 99),
+           samples ? s_latency_us[samples - 1] : 0,
+           uart_stats.rx_events,
+           core_stats.notifies,
+           core_stats.notifies ? (double)uart_stats.rx_events / core_stats.notifies : 0.0);
+
+    return completed;
+}
+
+void app_main(void)
+{
+    // initialize the interface for esp-at and host communication
+    at_interface_init();
+
+    // the emulated AT core must be ready before the interface is started
+    at_bench_core_start();
+    at_interface_start();
+
+    printf("%-16s %10s %8s %8s %8s %8s %8s %8s %8s %8s\n",
+           "scenario", "bytes/s", "writes", "p50(us)", "p90(us)", "p99(us)", "max(us)", "events", "notifies", "coalesce");
+
+    int exit_code = 0;
+    for (int i = 0; i < sizeof(s_scenarios) / sizeof(s_scenarios[0]); ++i) {
+        if (!at_bench_run(&s_scenarios[i])) {
+            ESP_LOGE(TAG, "abort the run");
+            exit_code = 1;
+            break;
+        }
+    }
+
+    fflush(stdout);
+    exit(exit_code);
+}
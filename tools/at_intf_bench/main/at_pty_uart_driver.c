@@ -0,0 +1,230 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <termios.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/stream_buffer.h"
+#include "esp_log.h"
+#include "esp_at.h"
+#include "driver/gpio.h"
+#include "driver/uart.h"
+#include "at_intf_bench.h"
+
+/**
+ * The uart driver of the linux target, which is backed by a pseudo-terminal.
+ *
+ * main/interface/uart/at_uart_task.c is built on top of it without any change: the emulated "rx interrupt"
+ * drains the pseudo-terminal in slices of rxfifo_full_thresh bytes (see uart_intr_config()) into the driver rx buffer,
+ * and posts one UART_DATA event per slice, or UART_BUFFER_FULL once the rx buffer is full.
+ * The "+++" pattern detection is not emulated.
+*/
+
+// static variables
+static int s_pty_master_fd = -1;
+static int s_pty_slave_fd = -1;
+static QueueHandle_t s_uart_queue = NULL;
+static StreamBufferHandle_t s_uart_rx_buf = NULL;
+static uint32_t s_uart_baudrate = 0;
+static uint8_t s_rxfifo_full_thresh = 0;
+static at_bench_uart_stats_t s_uart_stats;    // updated by the driver task, fetched by the bench, always accessed atomically
+static const char *TAG = "at-pty-uart";
+
+static void at_pty_uart_driver_task(void *params)
+{
+    uint8_t fifo[UINT8_MAX];
+
+    for (;;) {
+        // emulate rx fifo full/timeout interrupt: one event for each fifo slice
+        size_t space = xStreamBufferSpacesAvailable(s_uart_rx_buf);
+        if (space == 0) {
+            uart_event_t event = {.type = UART_BUFFER_FULL, .size = 0};
+            xQueueSend(s_uart_queue, &event, portMAX_DELAY);
+            __atomic_fetch_add(&s_uart_stats.rx_full_events, 1, __ATOMIC_RELAXED);
+            vTaskDelay(1);
+            continue;
+        }
+
+        uint8_t thresh = __atomic_load_n(&s_rxfifo_full_thresh, __ATOMIC_RELAXED);
+        ssize_t len = read(s_pty_slave_fd, fifo, at_min(thresh, space));
+        if (len <= 0) {
+            // no more data in the pseudo-terminal, wait for the next tick
+            vTaskDelay(1);
+            continue;
+        }
+
+        xStreamBufferSend(s_uart_rx_buf, fifo, len, portMAX_DELAY);
+        uart_event_t event = {.type = UART_DATA, .size = len};
+        xQueueSend(s_uart_queue, &event, portMAX_DELAY);
+        __atomic_fetch_add(&s_uart_stats.rx_events, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&s_uart_stats.rx_bytes, len, __ATOMIC_RELAXED);
+    }
+}
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size, int queue_size, QueueHandle_t *uart_queue, int intr_alloc_flags)
+{
+    // create the pseudo-terminal, the master side is left to the host traffic
+    s_pty_master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (s_pty_master_fd < 0 || grantpt(s_pty_master_fd) != 0 || unlockpt(s_pty_master_fd) != 0) {
+        ESP_LOGE(TAG, "create pty failed, errno:%d", errno);
+        return ESP_FAIL;
+    }
+
+    s_pty_slave_fd = open(ptsname(s_pty_master_fd), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (s_pty_slave_fd < 0) {
+        ESP_LOGE(TAG, "open pty slave failed, errno:%d", errno);
+        return ESP_FAIL;
+    }
+
+    // raw mode: no echo, no line discipline, just like a uart
+    struct termios tio;
+    tcgetattr(s_pty_slave_fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(s_pty_slave_fd, TCSANOW, &tio);
+
+    s_uart_queue = xQueueCreate(queue_size, sizeof(uart_event_t));
+    s_uart_rx_buf = xStreamBufferCreate(rx_buffer_size, 1);
+    if (!s_uart_queue || !s_uart_rx_buf) {
+        ESP_LOGE(TAG, "create driver queue failed");
+        return ESP_ERR_NO_MEM;
+    }
+    *uart_queue = s_uart_queue;
+
+    ESP_LOGI(TAG, "pty:%s", ptsname(s_pty_master_fd));
+
+    xTaskCreate(at_pty_uart_driver_task, "uDrv", 4096, NULL, 2, NULL);
+    return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *uart_config)
+{
+    s_uart_baudrate = uart_config->baud_rate;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_intr_config(uart_port_t uart_num, const uart_intr_config_t *intr_conf)
+{
+    if (intr_conf->rxfifo_full_thresh == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    __atomic_store_n(&s_rxfifo_full_thresh, intr_conf->rxfifo_full_thresh, __ATOMIC_RELAXED);
+    return ESP_OK;
+}
+
+esp_err_t uart_get_baudrate(uart_port_t uart_num, uint32_t *baudrate)
+{
+    *baudrate = s_uart_baudrate;
+    return ESP_OK;
+}
+
+esp_err_t uart_disable_rx_intr(uart_port_t uart_num)
+{
+    return ESP_OK;
+}
+
+int uart_write_bytes(uart_port_t uart_num, const void *src, size_t size)
+{
+    size_t had_written_len = 0;
+
+    while (had_written_len < size) {
+        ssize_t ret = write(s_pty_slave_fd, (const uint8_t *)src + had_written_len, size - had_written_len);
+        if (ret > 0) {
+            had_written_len += ret;
+        } else if (ret < 0 && errno == EAGAIN) {
+            vTaskDelay(1);
+        } else {
+            return -1;
+        }
+    }
+
+    return had_written_len;
+}
+
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length, TickType_t ticks_to_wait)
+{
+    uint32_t had_read_len = 0;
+    TickType_t start_ticks = xTaskGetTickCount();
+
+    // the same as the uart driver: wait until the requested length is read or the time is out
+    while (had_read_len < length) {
+        TickType_t elapsed_ticks = xTaskGetTickCount() - start_ticks;
+        TickType_t wait_ticks = (elapsed_ticks < ticks_to_wait) ? (ticks_to_wait - elapsed_ticks) : 0;
+        size_t ret = xStreamBufferReceive(s_uart_rx_buf, (uint8_t *)buf + had_read_len, length - had_read_len, wait_ticks);
+        if (ret == 0) {
+            break;
+        }
+        had_read_len += ret;
+    }
+
+    return had_read_len;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t *size)
+{
+    *size = xStreamBufferBytesAvailable(s_uart_rx_buf);
+    return ESP_OK;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait)
+{
+    return (tcdrain(s_pty_slave_fd) == 0) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t uart_flush_input(uart_port_t uart_num)
+{
+    xStreamBufferReset(s_uart_rx_buf);
+    return ESP_OK;
+}
+
+esp_err_t uart_enable_pattern_det_baud_intr(uart_port_t uart_num, char pattern_chr, uint8_t chr_num, int chr_tout, int post_idle, int pre_idle)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_disable_pattern_det_intr(uart_port_t uart_num)
+{
+    return ESP_OK;
+}
+
+int uart_pattern_get_pos(uart_port_t uart_num)
+{
+    return -1;
+}
+
+int uart_pattern_pop_pos(uart_port_t uart_num)
+{
+    return -1;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    return ESP_OK;
+}
+
+int at_bench_pty_master_fd(void)
+{
+    return s_pty_master_fd;
+}
+
+void at_bench_uart_stats_fetch(at_bench_uart_stats_t *stats)
+{
+    stats->rx_events = __atomic_exchange_n(&s_uart_stats.rx_events, 0, __ATOMIC_RELAXED);
+    stats->rx_full_events = __atomic_exchange_n(&s_uart_stats.rx_full_events, 0, __ATOMIC_RELAXED);
+    stats->rx_bytes = __atomic_exchange_n(&s_uart_stats.rx_bytes, 0, __ATOMIC_RELAXED);
+}
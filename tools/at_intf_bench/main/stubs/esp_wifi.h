@@ -0,0 +1,13 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+/**
+ * esp_at_core.h includes esp_wifi.h, but Wi-Fi is not available on the linux target.
+ * The interface layer does not use any Wi-Fi API, so only esp_idf_version.h, which at_uart.h relies on
+ * and is brought in by the real esp_wifi.h, is included for the host build.
+ */
+#include "esp_idf_version.h"
@@ -0,0 +1,11 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+/**
+ * main/interface/uart/at_uart_task.c includes soc/io_mux_reg.h, which is not available on the linux target.
+ * None of its definitions are used by the uart task, so an empty header is enough for the host build.
+ */
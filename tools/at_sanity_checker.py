@@ -4,12 +4,16 @@
 # SPDX-License-Identifier: Apache-2.0
 
 import os
+import re
 import sys
 import csv
 
 def ESP_LOGI(x):
     print(f'\033[32m{x}\033[0m')
 
+def ESP_LOGW(x):
+    print(f'\033[33m{x}\033[0m')
+
 def ESP_LOGE(x):
     sys.stderr.write(f'\033[31m{x}\n\033[0m')
 
@@ -64,6 +68,34 @@ def at_check_compress_ota_sanity(partition_base_dir):
 
     return ret
 
+def at_collect_cmd_names(components_dir):
+    """
+    Collect the command names of every esp_at_cmd_struct array in the components, return {name: [file, ...]}.
+    """
+    array_re = re.compile(r'esp_at_cmd_struct\s+\w+\s*\[\s*\]\s*=\s*\{(.*?)\n\};', re.S)
+    name_re = re.compile(r'\{\s*"(\+?[A-Za-z0-9_]+)"')
+    cmd_names = {}
+    for root, _, files in os.walk(components_dir):
+        for name in files:
+            if not name.endswith('.c'):
+                continue
+            path = os.path.join(root, name)
+            with open(path, 'r', errors='ignore') as f:
+                data = f.read()
+            for array in array_re.findall(data):
+                for cmd in name_re.findall(array):
+                    cmd_names.setdefault(cmd, []).append(os.path.relpath(path, repo_dir))
+    return cmd_names
+
+def at_check_cmd_name_sanity():
+    # the command table is built by the AT core at runtime, a duplicated name silently shadows the other one.
+    # the same name may be guarded by exclusive configurations, so it only warns
+    cmd_names = at_collect_cmd_names(os.path.join(repo_dir, 'components'))
+    for cmd, files in sorted(cmd_names.items()):
+        if len(files) > 1:
+            ESP_LOGW(f'AT command AT{cmd} is defined more than once: {", ".join(files)}, '
+                     f'please make sure only one of them is compiled.')
+
 def main():
     if len(sys.argv) != 2:
         raise Exception(f'Usage: {sys.argv[0]} <partition_base_dir>')
@@ -72,6 +104,8 @@ def main():
     if not at_check_compress_ota_sanity(partition_base_dir):
         sys.exit(1)
 
+    at_check_cmd_name_sanity()
+
 if __name__ == '__main__':
     try:
         main()